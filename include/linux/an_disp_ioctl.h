@@ -59,6 +59,10 @@ STATIC_ASSERT( sizeof( LCD_CGRAM_T ) == 9 );
 #define AN_DISPLAY_IOC_OFF                 _IO( AN_DISPLAY_IOC_MAGIC, 6 )
 #define AN_DISPLAY_IOC_LOAD_DEFAULT_CGRAM  _IO( AN_DISPLAY_IOC_MAGIC, 7 )
 #define AN_DISPLAY_IOC_WRITE_CGRAM         _IOW( AN_DISPLAY_IOC_MAGIC, 8, LCD_CGRAM_T )
+#define AN_DISPLAY_IOC_VERIFY_ON           _IO( AN_DISPLAY_IOC_MAGIC, 9 )
+#define AN_DISPLAY_IOC_VERIFY_OFF          _IO( AN_DISPLAY_IOC_MAGIC, 10 )
+#define AN_DISPLAY_IOC_SET_REFRESH         _IOW( AN_DISPLAY_IOC_MAGIC, 11, unsigned int )
+#define AN_DISPLAY_IOC_GET_REFRESH         _IOR( AN_DISPLAY_IOC_MAGIC, 12, unsigned int )
 
 
 #endif /* ifndef _AN_DISP_IOCTL_H */
@@ -22,11 +22,20 @@
 #define DT_TAG_RS  rs
 #define DT_TAG_RW  rw
 #define DT_TAG_EN  en
+#define DT_TAG_D0  d0
+#define DT_TAG_D1  d1
+#define DT_TAG_D2  d2
+#define DT_TAG_D3  d3
 #define DT_TAG_D4  d4
 #define DT_TAG_D5  d5
 #define DT_TAG_D6  d6
 #define DT_TAG_D7  d7
 
+#define DT_TAG_PUSH_PULL push-pull
+#define DT_TAG_CLK_DELAY clk-delay-ns
+#define DT_TAG_CONTROLLER controller
+#define DT_TAG_WRITE_ONLY write-only
+
 #define __TS( s ) #s
 #define TS( s ) __TS( s )
 
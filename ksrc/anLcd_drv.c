@@ -12,7 +12,16 @@
 #include "anLcd_drv.h"
 #include "anLcd_dev_tree_names.h"
 #include "hd44780Display.h"
+#include "anLcd_pcf8574.h"
+#include "anLcd_emulator.h"
 #include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/log2.h>
+#include <linux/vmalloc.h>
+
+#define CREATE_TRACE_POINTS
+#include "anLcd_trace.h"
 
 MODULE_LICENSE( "GPL" );
 MODULE_AUTHOR( "Ulrich Becker");
@@ -26,638 +35,2489 @@ MODULE_VERSION( __VERSION );
 
 #define PIN_PREFIX_NAME DEVICE_BASE_FILE_NAME
 
-#if !defined( CONFIG_OF ) || defined( CONFIG_AN_LCD_NO_DEV_TREE )
-  #define __NO_DEV_TREE
+/*!
+ * @brief Size in bytes of the write-FIFO of each display.
+ */
+static unsigned int mg_fifoSize = CONFIG_AN_LCD_FIFO_SIZE;
+module_param_named( fifoSize, mg_fifoSize, uint, S_IRUGO );
+MODULE_PARM_DESC( fifoSize, "Size in bytes of the write-FIFO of each display" );
+
+/*!
+ * @brief Default refresh-interval of each display in milliseconds.
+ */
+static unsigned int mg_refreshMs = CONFIG_AN_LCD_REFRESH_MS;
+module_param_named( refreshMs, mg_refreshMs, uint, S_IRUGO );
+MODULE_PARM_DESC( refreshMs, "Minimum time in ms between two flushes of written characters, 0: immediately" );
+
+GLOBAL_T global;
+
+/*!
+ * @brief Timing-profiles of the supported display-controllers, the values
+ *        are taken from the datasheets for the low supply-voltage range
+ *        (3.3 V), which covers the 5 V range as well.
+ *
+ * The profile becomes selected by the device-tree property "controller".
+ */
+static const LCD_TIMING_T mg_aTiming[] =
+{
+   {
+      .name      = "hd44780",
+      .setupNs   = 280,
+      .pulseNs   = 360,
+      .commandNs = 37000,
+      .dataNs    = 41000,
+      .clearNs   = 1520000,
+      .initMs    = 40
+   },
+   {
+      .name      = "st7066u",
+      .setupNs   = 740,
+      .pulseNs   = 230,
+      .commandNs = 37000,
+      .dataNs    = 41000,
+      .clearNs   = 1520000,
+      .initMs    = 40
+   },
+   {
+      .name      = "ks0070b",
+      .setupNs   = 280,
+      .pulseNs   = 360,
+      .commandNs = 39000,
+      .dataNs    = 43000,
+      .clearNs   = 1530000,
+      .initMs    = 30
+   }
+};
+
+#ifdef CONFIG_ST7066U
+  #define LCD_DEFAULT_TIMING (&mg_aTiming[1])
+#else
+  #define LCD_DEFAULT_TIMING (&mg_aTiming[0])
 #endif
 
-GLOBAL_T global =
+static const LCD_TRANSPORT_T mg_gpioTransport;
+
+/*!
+ * @brief Default settings of a display-object, becomes copied in each new
+ *        object by onProbe().
+ */
+static const LCD_OBJ_T mg_defaultLcd =
 {
-   .oLcd =
+ #ifdef __NO_DEV_TREE
+   .maxX = CONFIG_AN_LCD_MAX_X,
+   .maxY = CONFIG_AN_LCD_MAX_Y,
+ #endif
+   .isInitialized = false,
+ #ifdef CONFIG_AN_LCD_WRITE_ONLY
+   .writeOnly = true,
+ #endif
+ #ifdef CONFIG_AN_LCD_PUSH_PULL
+   .pushPull = true,
+ #endif
+   .clkDelayNs = LCD_MAX_CLK_DELAY_NS,
+   .clkSource = CLK_DEFAULT,
+   .pTiming = LCD_DEFAULT_TIMING,
+   .pTransport = &mg_gpioTransport,
+   .port =
    {
-    #ifdef __NO_DEV_TREE
-      .maxX = CONFIG_AN_LCD_MAX_X,
-      .maxY = CONFIG_AN_LCD_MAX_Y,
-    #endif
-      .isInitialized = false,
-      .port =
+      .rs =
+      {
+         .name = TS(DT_TAG_RS),
+      #ifdef __NO_DEV_TREE
+         .number = CONFIG_AN_LCD_GPIO_NUMBER_RS,
+      #endif
+         .init = OUTPUT_HIGH,
+         .initialized = FALSE
+      },
+      .rw =
+      {
+         .name = TS(DT_TAG_RW),
+      #if defined( __NO_DEV_TREE ) && !defined( CONFIG_AN_LCD_WRITE_ONLY )
+         .number = CONFIG_AN_LCD_GPIO_NUMBER_RW,
+      #endif
+         .init = OUTPUT_HIGH,
+         .initialized = FALSE
+      },
+      .en =
+      {
+         .name = TS(DT_TAG_EN),
+      #ifdef __NO_DEV_TREE
+         .number = CONFIG_AN_LCD_GPIO_NUMBER_EN,
+      #endif
+         .init = OUTPUT_HIGH,
+         .initialized = FALSE
+      },
+      .data =
       {
-         .rs =
          {
-            .name = TS(DT_TAG_RS),
+            .pin.name = TS(DT_TAG_D4),
+         #ifdef __NO_DEV_TREE
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D4,
+         #endif
+            .pin.init = INPUT,
+            .pin.initialized = FALSE,
+            .mask = (1 << 4)
+         },
+         {
+            .pin.name = TS(DT_TAG_D5),
          #ifdef __NO_DEV_TREE
-            .number = CONFIG_AN_LCD_GPIO_NUMBER_RS,
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D5,
          #endif
-            .init = INPUT,
-            .initialized = FALSE
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 5)
          },
-         .rw =
          {
-            .name = TS(DT_TAG_RW),
+            .pin.name = TS(DT_TAG_D6),
          #ifdef __NO_DEV_TREE
-            .number = CONFIG_AN_LCD_GPIO_NUMBER_RW,
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D6,
          #endif
-            .init = INPUT,
-            .initialized = FALSE
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 6)
          },
-         .en =
          {
-            .name = TS(DT_TAG_EN),
+            .pin.name = TS(DT_TAG_D7),
          #ifdef __NO_DEV_TREE
-            .number = CONFIG_AN_LCD_GPIO_NUMBER_EN,
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D7,
+         #endif
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 7)
+         },
+         {
+            .pin.name = TS(DT_TAG_D0),
+         #if defined( __NO_DEV_TREE ) && defined( CONFIG_AN_LCD_DATAPORT_PINS_8 )
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D0,
+         #endif
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 0)
+         },
+         {
+            .pin.name = TS(DT_TAG_D1),
+         #if defined( __NO_DEV_TREE ) && defined( CONFIG_AN_LCD_DATAPORT_PINS_8 )
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D1,
+         #endif
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 1)
+         },
+         {
+            .pin.name = TS(DT_TAG_D2),
+         #if defined( __NO_DEV_TREE ) && defined( CONFIG_AN_LCD_DATAPORT_PINS_8 )
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D2,
          #endif
-            .init = INPUT,
-            .initialized = FALSE
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 2)
          },
-         .data =
          {
-            {
-               .pin.name = TS(DT_TAG_D4),
-            #ifdef __NO_DEV_TREE
-               .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D4,
-            #endif
-               .pin.init = INPUT,
-               .pin.initialized = FALSE,
-               .mask = (1 << 0)
-            },
-            {
-               .pin.name = TS(DT_TAG_D5),
-            #ifdef __NO_DEV_TREE
-               .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D5,
-            #endif
-               .pin.initialized = FALSE,
-               .pin.init = INPUT,
-               .mask = (1 << 1)
-            },
-            {
-               .pin.name = TS(DT_TAG_D6),
-            #ifdef __NO_DEV_TREE
-               .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D6,
-            #endif
-               .pin.initialized = FALSE,
-               .pin.init = INPUT,
-               .mask = (1 << 2)
-            },
-            {
-               .pin.name = TS(DT_TAG_D7),
-            #ifdef __NO_DEV_TREE
-               .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D7,
-            #endif
-               .pin.initialized = FALSE,
-               .pin.init = INPUT,
-               .mask = (1 << 3)
-            }
-         } /* .data = */
-      } /* .port = */
-   }, /* .oLcd = */
-   .oWaitQueue.bussy = false
+            .pin.name = TS(DT_TAG_D3),
+         #if defined( __NO_DEV_TREE ) && defined( CONFIG_AN_LCD_DATAPORT_PINS_8 )
+            .pin.number = CONFIG_AN_LCD_GPIO_NUMBER_D3,
+         #endif
+            .pin.initialized = FALSE,
+            .pin.init = INPUT,
+            .mask = (1 << 3)
+         }
+      }, /* .data = */
+   #if defined( __NO_DEV_TREE ) && defined( CONFIG_AN_LCD_DATAPORT_PINS_8 )
+      .dataCount = 8
+   #else
+      .dataCount = 4
+   #endif
+   } /* .port = */
 };
 
 /*!----------------------------------------------------------------------------
+ * @brief Converts the kind of driving in a human readable ASCII-string.
  */
-int writeLcdPort( u8 data )
+static const char* getDriveStr( DRIVE_T drive )
 {
-   int i;
-
-   for( i = 0; i < ARRAY_SIZE( global.oLcd.port.data ); i++ )
+   #define DRIVE_CASE_ITEM( s ) case s: return #s;
+   switch( drive )
    {
-      if( (global.oLcd.port.data[i].mask & data) != 0 )
-         gpio_direction_input( global.oLcd.port.data[i].pin.number );
-      else
-         gpio_direction_output( global.oLcd.port.data[i].pin.number, 0 );
+      DRIVE_CASE_ITEM( OPEN_DRAIN_EMULATED );
+      DRIVE_CASE_ITEM( OPEN_DRAIN );
+      DRIVE_CASE_ITEM( PUSH_PULL );
    }
-   return 0;
+   #undef DRIVE_CASE_ITEM
+   return "undefined";
 }
 
 /*!----------------------------------------------------------------------------
+ * @brief Converts the origin of the CLK-delay in a human readable ASCII-string.
  */
-BYTE readLcdPort( void )
+static const char* getClkSourceStr( CLK_SOURCE_T source )
 {
-   int i;
-   BYTE ret = 0;
-   for( i = 0; i < ARRAY_SIZE( global.oLcd.port.data ); i++ )
+   switch( source )
    {
-      if( gpio_get_value( global.oLcd.port.data[i].pin.number ) != 0 )
-         ret |= global.oLcd.port.data[i].mask;
+      case CLK_DEFAULT:     return "default";
+      case CLK_CALIBRATED:  return "calibrated";
+      case CLK_DEVICE_TREE: return "device-tree";
+      case CLK_SYSFS:       return "sysfs";
    }
-   return ret;
+   return "undefined";
 }
 
-/* Device file operations begin **********************************************/
 /*!----------------------------------------------------------------------------
- * @brief Callback function becomes invoked by the function open() from the
- *        user-space.
+ * @brief Returns the timing-profile of the display-controller given by
+ *        name, or NULL if the controller is unknown.
  */
-static int onOpen( struct inode* pInode, struct file* pInstance )
+const LCD_TIMING_T* findTiming( const char* name )
 {
-   DEBUG_MESSAGE( ": Minor-number: %d\n", MINOR(pInode->i_rdev) );
-   BUG_ON( pInstance->private_data != NULL );
-   atomic_inc( &global.oLcd.openCount );
-   DEBUG_MESSAGE( ":   Open-counter: %d\n", 
-                  atomic_read( &global.oLcd.openCount ));
+   int i;
 
-   return 0;
+   for( i = 0; i < ARRAY_SIZE( mg_aTiming ); i++ )
+   {
+      if( strcmp( name, mg_aTiming[i].name ) == 0 )
+         return &mg_aTiming[i];
+   }
+   return NULL;
 }
 
 /*!----------------------------------------------------------------------------
- * @brief Callback function becomes invoked by the function close() from the
- *        user-space.
+ * @brief Sets the level of a single control-pin (rs, rw or en).
+ *
+ * In the mode OPEN_DRAIN_EMULATED the high-level becomes produced by the
+ * pull-up resistor of the released pin, otherwise only the value becomes
+ * written.
  */
-static int onClose( struct inode *pInode, struct file* pInstance )
+void setLcdPin( LCD_GPIO_PIN_T* pPin, int value )
 {
-   DEBUG_MESSAGE( ": Minor-number: %d\n", MINOR(pInode->i_rdev) );
-   atomic_dec( &global.oLcd.openCount );
-   DEBUG_MESSAGE( "   Open-counter: %d\n", 
-                  atomic_read( &global.oLcd.openCount ));
-   return 0;
+   if( pPin->drive != OPEN_DRAIN_EMULATED )
+      gpiod_set_value_cansleep( pPin->pDesc, value );
+   else if( value != 0 )
+      gpiod_direction_input( pPin->pDesc );
+   else
+      gpiod_direction_output( pPin->pDesc, 0 );
 }
 
-#ifdef CONFIG_AN_LCD_READBACK
 /*!----------------------------------------------------------------------------
- * @brief Callback function becomes invoked by the function read() from the
- *        user-space.
- * @note The kernel invokes onRead as many times till it returns 0 !!!
  */
-static ssize_t onRead( struct file* pInstance,   /*!< @see include/linux/fs.h   */
-                       char __user* pBuffer,     /*!< buffer to fill with data */
-                       size_t len,               /*!< length of the buffer     */
-                       loff_t* pOffset )
+static int setDataArray( LCD_OBJ_T* pLcd, unsigned long bitmap )
 {
-   char tmp[(MAX_X() * MAX_Y()) * 2 + MAX_Y() + 1];
-   char c;
-   ssize_t n, i;
-   int x, y;
-   LCD_ADDR_T oldAddr;
-
-   DEBUG_MESSAGE( ": len = %ld, offset = %lld\n", (long int)len, *pOffset );
-   DEBUG_ACCESSMODE( pInstance );
-
-   DEBUG_MESSAGE( "   Open-counter: %d\n", 
-                  atomic_read( &global.oLcd.openCount ));
-
-   if( global.oWaitQueue.bussy && ((pInstance->f_flags & O_NONBLOCK) != 0) )
-      return -EAGAIN;
-   if( wait_event_interruptible( global.oWaitQueue.queue, !global.oWaitQueue.bussy ) )
-      return -ERESTARTSYS;
-
-
-   n = min( len, (sizeof(tmp)-1) );
-   n -= (*pOffset);
-   if( n <= 0 )
-      return n;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 0, 0)
+   return gpiod_set_array_value_cansleep( pLcd->port.dataCount,
+                                          pLcd->port.dataDesc,
+                                          NULL, &bitmap );
+#else
+   int i;
+   int values[ARRAY_SIZE( pLcd->port.dataDesc )];
 
-   global.oWaitQueue.bussy = true;
-   DEBUG_MESSAGE( " n = %d\n", n );
+   for( i = 0; i < pLcd->port.dataCount; i++ )
+      values[i] = (bitmap & (1UL << i)) != 0;
+   gpiod_set_array_value_cansleep( pLcd->port.dataCount,
+                                   pLcd->port.dataDesc, values );
+   return 0;
+#endif
+}
 
-   if( !global.oLcd.isInitialized )
-   {
-      lcdInit();
-      global.oLcd.isInitialized = true;
-   }
+/*!----------------------------------------------------------------------------
+ * @brief Puts the byte on the data-pins, in 4-bit mode only the bits
+ *        of D4 till D7 are used.
+ *
+ * If the gpio-chip supports open-drain respectively in the push-pull mode
+ * all data-pins becomes set by a single call of
+ * gpiod_set_array_value_cansleep(), so gpio-chips which supports that can
+ * update all pins by one register-access.
+ */
+int writeLcdPort( LCD_OBJ_T* pLcd, u8 data )
+{
+   int i;
+   unsigned long bitmap = 0;
 
-   if( lcdIsBusy( &oldAddr ) )
+   for( i = 0; i < pLcd->port.dataCount; i++ )
    {
-      ERROR_MESSAGE( ": LCD seems to be busy...\n" );
-      goto L_LIMIT;
+      if( (pLcd->port.data[i].mask & data) != 0 )
+         bitmap |= (1UL << i);
    }
+   LCD_CAPTURE( pLcd, (pLcd->port.dataMask << LCD_CAPTURE_DATA_SHIFT) |
+                      LCD_CAPTURE_DATA_Z,
+                (data & pLcd->port.dataMask) << LCD_CAPTURE_DATA_SHIFT );
 
-   i = 0;
-   for( y = 0; y < MAX_Y(); y++ )
+   switch( pLcd->port.dataDrive )
    {
-      if( lcdSetAddress( lcdLine2Addr( (BYTE)y ) ) < 0 )
-         goto L_LIMIT;
-      for( x = 0; x < MAX_X(); x++ )
+      case OPEN_DRAIN:
       {
-         c = lcdGetChar();
-      #ifdef _CONVERT_CHAR8
-         lcdConvertBackChar8( &c );
-      #endif
-      #ifdef CONFIG_LCD_UNICODE
-         if( lcdConvertBackSpecialChar( &c ) )
-         {
-            if( i < (n-1) )
-               tmp[i++] = LCD_SPECIAL_CHAR_INTRUDUCHER;
-            else
-               goto L_LIMIT;
-         }
-       #ifndef CONFIG_LCD_NO_UMLAUT
-         else if( lcdConvertBackUmlaut( &c ) )
-         {
-            if( i < (n-1) )
-               tmp[i++] = LCD_UMLAUT_INTRUDUCHER;
-            else
-               goto L_LIMIT;
-         }
-       #endif /* ifndef CONFIG_LCD_NO_UMLAUT */
-      #endif /* ifdef CONFIG_LCD_UNICODE */
-         if( i < n )
-           tmp[i++] = c;
-         else
-           goto L_LIMIT;
+         return setDataArray( pLcd, bitmap );
       }
-      if( i < n )
-         tmp[i++] = '\n';
-      else
+      case PUSH_PULL:
+      {
+         if( pLcd->port.dataIsOutput )
+            return setDataArray( pLcd, bitmap );
+         for( i = 0; i < pLcd->port.dataCount; i++ )
+            gpiod_direction_output( pLcd->port.dataDesc[i],
+                                    (bitmap & (1UL << i)) != 0 );
+         pLcd->port.dataIsOutput = true;
+         break;
+      }
+      default: /* OPEN_DRAIN_EMULATED */
+      {
+         for( i = 0; i < pLcd->port.dataCount; i++ )
+            setLcdPin( &pLcd->port.data[i].pin, (bitmap & (1UL << i)) != 0 );
+         pLcd->port.dataIsOutput = (bitmap != (1UL << pLcd->port.dataCount) - 1);
          break;
+      }
    }
+   return 0;
+}
 
-L_LIMIT:
-   tmp[i] = '\0';
-   global.oWaitQueue.bussy = false;
-   lcdSetAddress( oldAddr );
+/*!----------------------------------------------------------------------------
+ * @brief Releases the data-pins, so the display can drive them.
+ *
+ * The directions becomes switched only when at least one data-pin is
+ * driven, e.g. a busy-poll following a read doesn't cost any
+ * gpio-operation.
+ */
+void releaseLcdPort( LCD_OBJ_T* pLcd )
+{
+   int i;
 
-   DEBUG_MESSAGE( " i = %d\n", i );
-   if( copy_to_user( pBuffer, tmp, i ) != 0 )
+   LCD_CAPTURE( pLcd, LCD_CAPTURE_DATA_Z, LCD_CAPTURE_DATA_Z );
+
+   if( pLcd->port.dataDrive == OPEN_DRAIN )
    {
-      ERROR_MESSAGE( "copy_to_user\n" );
-      global.oWaitQueue.bussy = false;
-      return -EFAULT;
+      setDataArray( pLcd, (1UL << pLcd->port.dataCount) - 1 );
+      return;
    }
-
-   (*pOffset) += n;
-   global.oWaitQueue.bussy = false;
-   return i;
-   /* Number of bytes successfully read. */
+   if( !pLcd->port.dataIsOutput )
+      return;
+   for( i = 0; i < pLcd->port.dataCount; i++ )
+      gpiod_direction_input( pLcd->port.dataDesc[i] );
+   pLcd->port.dataIsOutput = false;
 }
-#endif /* ifdef CONFIG_AN_LCD_READBACK */
 
 /*!----------------------------------------------------------------------------
- * @brief Callback function becomes invoked by the function write() from the
- *        user-space.
  */
-static ssize_t onWrite( struct file *pInstance,
-                        const char __user* pBuffer,
-                        size_t len,
-                        loff_t* pOffset )
+BYTE readLcdPort( LCD_OBJ_T* pLcd )
 {
-   size_t notCopied;
-   DEBUG_MESSAGE( ": len = %ld, offset = %lld\n", (long int)len, *pOffset );
-   DEBUG_ACCESSMODE( pInstance );
-   DEBUG_MESSAGE( "   Open-counter: %d\n", 
-                  atomic_read( &global.oLcd.openCount ));
-
-   if( global.oWaitQueue.bussy && ((pInstance->f_flags & O_NONBLOCK) != 0) )
-      return -EAGAIN;
-   if( wait_event_interruptible( global.oWaitQueue.queue, !global.oWaitQueue.bussy ) )
-      return -ERESTARTSYS;
-
-   global.oWaitQueue.bussy = true;
-
-   global.oBuffer.len = min( len, global.oBuffer.capacity );
-   notCopied = copy_from_user( global.oBuffer.pData, pBuffer, global.oBuffer.len );
-   global.oBuffer.len -= notCopied;
+   int i;
+   BYTE ret = 0;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 0, 0)
+   unsigned long bitmap = 0;
 
-   if( global.oBuffer.len == 0 )
-   {
-      global.oWaitQueue.bussy = false;
+   if( gpiod_get_array_value_cansleep( pLcd->port.dataCount,
+                                       pLcd->port.dataDesc,
+                                       NULL, &bitmap ) < 0 )
       return 0;
+   for( i = 0; i < pLcd->port.dataCount; i++ )
+   {
+      if( (bitmap & (1UL << i)) != 0 )
+         ret |= pLcd->port.data[i].mask;
    }
-
-   queue_work( global.oWorkQueue.poWorkqueue, &global.oWorkQueue.oWrite );
-   return global.oBuffer.len;
+#else
+   for( i = 0; i < pLcd->port.dataCount; i++ )
+   {
+      if( gpiod_get_value_cansleep( pLcd->port.dataDesc[i] ) != 0 )
+         ret |= pLcd->port.data[i].mask;
+   }
+#endif
+   LCD_CAPTURE( pLcd, pLcd->port.dataMask << LCD_CAPTURE_DATA_SHIFT,
+                ret << LCD_CAPTURE_DATA_SHIFT );
+   return ret;
 }
 
-/*=========================== ioctl handling ================================*/
 /*!----------------------------------------------------------------------------
+ * @brief Waits the given time in nanoseconds.
+ *
+ * Only the short delays between the edges of the bus-signals are
+ * busy-spinning, all longer waits releases the CPU. The bus is accessed
+ * in process-context only, protected by oBusMutex.
  */
-static long onIoctlReset( unsigned long arg )
+void lcdDelayNs( LCD_OBJ_T* pLcd, unsigned int ns )
 {
-   if( lcdInit() < 0 )
-      return -EFAULT;
+   unsigned int us;
 
-   global.oLcd.isInitialized = true;
-   return 0;
+   if( ns <= CONFIG_AN_LCD_MAX_SPIN_NS )
+   {
+      ndelay( ns );
+      pLcd->oStatistic.delayNs += ns;
+      return;
+   }
+   if( ns >= LCD_MSLEEP_MIN_NS )
+      msleep( DIV_ROUND_UP( ns, NSEC_PER_MSEC ) );
+   else
+   {
+      us = DIV_ROUND_UP( ns, NSEC_PER_USEC );
+      usleep_range( us, us + us / LCD_SLEEP_SLACK_DIV );
+   }
+   pLcd->oStatistic.sleepNs += ns;
 }
 
+#ifdef CONFIG_PROC_FS
 /*!----------------------------------------------------------------------------
  */
-static long onIoctlScrollUp( unsigned long arg )
+static void gpioShow( LCD_OBJ_T* pLcd, struct seq_file* pSeqFile )
 {
-   if( lcdScrollUp() < 0 )
-      return -EFAULT;
-   return 0;
+   seq_printf( pSeqFile, "GPIO drive: %s\n",
+               getDriveStr( pLcd->port.dataDrive ) );
+   seq_printf( pSeqFile, "CLK delay: %u ns (%s)\n",
+               READ_ONCE( pLcd->clkDelayNs ),
+               getClkSourceStr( READ_ONCE( pLcd->clkSource ) ) );
 }
+#endif
+
+/*!
+ * @brief Transport of the displays connected directly to GPIO-pins, the
+ *        bus-signals becomes bit-banged by the core.
+ */
+static const LCD_TRANSPORT_T mg_gpioTransport =
+{
+   .name        = "gpio",
+   .idle        = lcdBitBangIdle,
+   .writeNibble = lcdBitBangWriteNibble,
+   .writeByte   = lcdBitBangWriteByte,
+   .readByte    = lcdBitBangReadByte,
+   .delay       = lcdDelayNs,
+   .flush       = NULL,
+#ifdef CONFIG_PROC_FS
+   .show        = gpioShow,
+#endif
+   .hasClkDelay = true
+};
 
+#ifdef CONFIG_AN_LCD_BUS_CAPTURE
 /*!----------------------------------------------------------------------------
+ * @brief Records the levels of all bus-signals in the capture ring-buffer
+ *        when a signal given by mask has changed.
+ *
+ * Releasing the data-pins makes their levels unknown till they becomes
+ * read or written again.
  */
-static long onIoctlScrollDown( unsigned long arg )
+void lcdCaptureSignal( LCD_OBJ_T* pLcd, unsigned int mask, unsigned int value )
 {
-   if( lcdScrollDown() < 0 )
-      return -EFAULT;
-   return 0;
+   LCD_CAPTURE_T* pCapture = &pLcd->oCapture;
+   LCD_CAPTURE_ITEM_T next = pCapture->current;
+
+   next.value = (next.value & ~mask) | (value & mask);
+   next.known |= mask;
+   if( (mask & value & LCD_CAPTURE_DATA_Z) != 0 )
+      next.known &= ~LCD_CAPTURE_DATA;
+
+   if( (next.value == pCapture->current.value) &&
+       (next.known == pCapture->current.known) )
+      return;
+
+   next.time = ktime_get_ns();
+   pCapture->current = next;
+   pCapture->pRing[pCapture->head & (CONFIG_AN_LCD_BUS_CAPTURE_SIZE - 1)] = next;
+   /* Makes the item visible for readers. */
+   smp_store_release( &pCapture->head, pCapture->head + 1 );
 }
+#endif /* ifdef CONFIG_AN_LCD_BUS_CAPTURE */
 
+/* Latency measurement begin *************************************************/
+#ifdef CONFIG_DEBUG_FS
 /*!----------------------------------------------------------------------------
+ * @brief Adds a duration to the bucket floor( log2( ns ) ) of the histogram.
+ * @note Becomes invoked under oLatency.stampLock only.
  */
-static long onIoctlLoadDefaultCgRam( unsigned long arg )
+static void histogramAdd( LCD_HISTOGRAM_T* pHist, u64 ns )
 {
-   LCD_ADDR_T addr;
-
-   if( lcdIsBusy( &addr ) )
-   {
-      ERROR_MESSAGE( ": LCD is still busy!\n" );
-      return -EFAULT;
-   }
-   lcdLoadPredefinedExtraCharacters();
-   if( lcdSetAddress( addr ) < 0 )
-      return -EFAULT;
-
-   return 0;
+   unsigned int i = (ns > 1)? ilog2( ns ) : 0;
+
+   if( i >= ARRAY_SIZE( pHist->count ) )
+      i = ARRAY_SIZE( pHist->count ) - 1;
+   pHist->count[i]++;
+   pHist->samples++;
+   pHist->sum += ns;
+   if( ns > pHist->max )
+      pHist->max = ns;
 }
 
 /*!----------------------------------------------------------------------------
+ * @brief Stores the time-stamp of the entry in write() together with the
+ *        number of all written bytes including this write().
+ * @note Becomes invoked under oWriteMutex only.
  */
-static long onIoctlWriteCgRam( unsigned long arg )
+static void latencyWriteStamp( LCD_OBJ_T* pLcd, u64 time )
 {
-   LCD_CGRAM_T cgRamBuffer;
-   int ret = 0;
-   LCD_ADDR_T addr;
+   LCD_LATENCY_T* pLatency = &pLcd->oLatency;
+   LCD_WRITE_STAMP_T* pStamp;
 
-   if( lcdIsBusy( &addr ) )
+   spin_lock( &pLatency->stampLock );
+   if( (pLatency->stampHead - pLatency->stampTail) < LCD_WRITE_STAMPS )
    {
-      ERROR_MESSAGE( ": LCD is still busy!\n" );
-      return -EFAULT;
+      pStamp = &pLatency->aStamp[pLatency->stampHead % LCD_WRITE_STAMPS];
+      pStamp->time = time;
+      pStamp->end  = pLcd->oStatistic.bytesWritten;
+      pLatency->stampHead++;
    }
+   spin_unlock( &pLatency->stampLock );
+}
 
-   if( copy_from_user( &cgRamBuffer, (void*)arg, sizeof( cgRamBuffer ) ) != 0 )
-   {
-      ERROR_MESSAGE( ": copy_from_user failed\n" );
-      return -EFAULT;
-   }
+/*!----------------------------------------------------------------------------
+ * @brief Becomes invoked after a snapshot of the screen-model containing
+ *        the first "bytes" written bytes was flushed to the display.
+ *
+ * Each write() whose last byte is on the display now becomes added to
+ * the write-histogram.
+ */
+static void latencyFlushed( LCD_OBJ_T* pLcd, u64 bytes )
+{
+   LCD_LATENCY_T* pLatency = &pLcd->oLatency;
+   LCD_WRITE_STAMP_T* pStamp;
+   u64 now = ktime_get_ns();
 
-   if( lcdLoadExtraCharP( cgRamBuffer.content, cgRamBuffer.address ) < 0 )
+   spin_lock( &pLatency->stampLock );
+   pLatency->flushed = bytes;
+   while( pLatency->stampTail != pLatency->stampHead )
    {
-      ERROR_MESSAGE( ": writing of CG-RAM failed\n" );
-      ret = -EFAULT;
+      pStamp = &pLatency->aStamp[pLatency->stampTail % LCD_WRITE_STAMPS];
+      if( pStamp->end > pLatency->flushed )
+         break;
+      histogramAdd( &pLatency->write, now - pStamp->time );
+      pLatency->stampTail++;
    }
-
-   if( lcdSetAddress( addr ) < 0 )
-      return -EFAULT;
-
-   return ret;
+   spin_unlock( &pLatency->stampLock );
 }
 
 /*!----------------------------------------------------------------------------
+ * @brief Adds a duration to a histogram of the display.
  */
-static long onIoctlAutoScrollOn( unsigned long arg )
+void lcdLatencyAdd( LCD_OBJ_T* pLcd, LCD_HISTOGRAM_T* pHist, u64 ns )
 {
-   lcdEnableAutoScroll();
-   return 0;
+   spin_lock( &pLcd->oLatency.stampLock );
+   histogramAdd( pHist, ns );
+   spin_unlock( &pLcd->oLatency.stampLock );
 }
 
 /*!----------------------------------------------------------------------------
  */
-static long onIoctlAutoScrollOff( unsigned long arg )
+static void latencyIoctl( LCD_OBJ_T* pLcd, unsigned int cmd, u64 ns )
 {
-   lcdDisableAutoScroll();
-   return 0;
+   if( _IOC_NR( cmd ) < ARRAY_SIZE( pLcd->oLatency.ioctl ) )
+      lcdLatencyAdd( pLcd, &pLcd->oLatency.ioctl[_IOC_NR( cmd )], ns );
 }
 
+#else /* ifdef CONFIG_DEBUG_FS */
+
+static inline void latencyWriteStamp( LCD_OBJ_T* pLcd, u64 time ) {}
+static inline void latencyFlushed( LCD_OBJ_T* pLcd, u64 bytes ) {}
+static inline void latencyIoctl( LCD_OBJ_T* pLcd, unsigned int cmd, u64 ns ) {}
+
+#endif /* else ifdef CONFIG_DEBUG_FS */
+/* Latency measurement end ***************************************************/
+
+/* Device file operations begin **********************************************/
 /*!----------------------------------------------------------------------------
+ * @brief Returns true when the display is initialized.
+ *
+ * Ioctl-commands waiting for this, so their changes reach the
+ * display-controller not before its initialization.
+ * A removed display counts as ready, so the waiting tasks wake up and
+ * get -ENODEV.
  */
-static long onIoctlDisplayOff( unsigned long arg )
+static inline bool isReady( LCD_OBJ_T* pLcd )
 {
-   if( lcdOff() < 0 )
-      return -EFAULT;
-   return 0;
+   return pLcd->isInitialized || READ_ONCE( pLcd->isRemoved );
 }
 
 /*!----------------------------------------------------------------------------
+ * @brief Returns true when furthermore nobody accesses the display, the
+ *        write-FIFO is empty and all changes of the screen-model are
+ *        flushed, that means all written characters are on the display.
+ *
+ * Read-verify and the proc-file waiting for this.
  */
-static long onIoctlDisplayOn( unsigned long arg )
+static inline bool isIdle( LCD_OBJ_T* pLcd )
 {
-   if( lcdOn() < 0 )
-      return -EFAULT;
-   return 0;
+   if( READ_ONCE( pLcd->isRemoved ) )
+      return true;
+   return isReady( pLcd ) && !pLcd->dirty &&
+          kfifo_is_empty( &pLcd->oFifo ) &&
+          !mutex_is_locked( &pLcd->oBusMutex );
 }
 
 /*!----------------------------------------------------------------------------
+ * @brief Locks a mutex of the display and counts its contention in pStat.
+ *
+ * The statistic becomes updated while the mutex is held, so it needs
+ * no further protection.
  */
-typedef struct
+static int lockMeasured( struct mutex* pMutex, LCD_LOCK_STATISTIC_T* pStat,
+                         bool interruptible )
 {
-   char*        name;
-   unsigned int number;
-   long (*function)( unsigned long arg );
-} IOC_INFO_T;
+   u64 start;
 
-#define IOCTL_ITEM( n, f ) { #n, n, f }
+   if( mutex_trylock( pMutex ) )
+      return 0;
 
-/*!
- * @todo Ioctl-dummy handling of TCGETS and TCSETS defined in "termios.h"
- */
+   start = ktime_get_ns();
+   if( interruptible )
+   {
+      if( mutex_lock_interruptible( pMutex ) )
+         return -ERESTARTSYS;
+   }
+   else
+      mutex_lock( pMutex );
 
-const static IOC_INFO_T mg_ioctlList[] =
-{
-   IOCTL_ITEM( AN_DISPLAY_IOC_RESET,              onIoctlReset ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_SCROLL_UP,          onIoctlScrollUp ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_SCROLL_DOWN,        onIoctlScrollDown ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_LOAD_DEFAULT_CGRAM, onIoctlLoadDefaultCgRam ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_WRITE_CGRAM,        onIoctlWriteCgRam ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_AUTOSCROLL_ON,      onIoctlAutoScrollOn ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_AUTOSCROLL_OFF,     onIoctlAutoScrollOff ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_OFF,                onIoctlDisplayOff ),
-   IOCTL_ITEM( AN_DISPLAY_IOC_ON,                 onIoctlDisplayOn ),
-   { NULL, 0, NULL }
-};
+   pStat->contended++;
+   pStat->waitNs += ktime_get_ns() - start;
+   return 0;
+}
 
 /*!----------------------------------------------------------------------------
- * @brief Callback function becomes invoked by the function ioctrl() from the
- *        user-space.
+ * @brief Interprets the characters of the write-FIFO by the escape- and
+ *        UTF-8-parser against the screen-model.
+ * @note oStateMutex has to be held, so this is the single consumer of
+ *       the FIFO.
  */
-static long onIoctrl( struct file* pInstance,
-                      unsigned int cmd,
-                      unsigned long arg )
+static void parseFifo( LCD_OBJ_T* pLcd )
 {
-   int ret;
-   const IOC_INFO_T* pCurrentItem;
+   u8 buffer[64];
+   unsigned int len, i;
+   bool wasFull = kfifo_is_full( &pLcd->oFifo );
+
+   while( (len = kfifo_out( &pLcd->oFifo, buffer, sizeof( buffer ) )) > 0 )
+   {
+      for( i = 0; i < len; i++ )
+      {
+         if( buffer[i] != '\0' )
+            lcdPutch( pLcd, buffer[i] );
+      }
+      pLcd->bytesParsed += len;
+      pLcd->dirty = true;
+   }
+   /* Pollers waiting for free space in the FIFO. */
+   if( wasFull )
+      wake_up( &pLcd->oWaitQueue.queue );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Locks the screen-model, this lock becomes held for short
+ *        memory-operations only.
+ *
+ * The characters still in the write-FIFO becomes parsed first, so each
+ * holder of the lock sees all preceding writes.
+ */
+static inline void lockState( LCD_OBJ_T* pLcd )
+{
+   lockMeasured( &pLcd->oStateMutex, &pLcd->oStatistic.stateLock, false );
+   parseFifo( pLcd );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Like lockState() but without waiting.
+ * @retval true The lock is held.
+ */
+static inline bool trylockState( LCD_OBJ_T* pLcd )
+{
+   if( !mutex_trylock( &pLcd->oStateMutex ) )
+      return false;
+   parseFifo( pLcd );
+   return true;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static inline void unlockState( LCD_OBJ_T* pLcd )
+{
+   mutex_unlock( &pLcd->oStateMutex );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Locks the access to the display-controller.
+ * @retval -ENODEV The display is removed, the lock is not held.
+ */
+static inline int lockBus( LCD_OBJ_T* pLcd, bool interruptible )
+{
+   if( lockMeasured( &pLcd->oBusMutex, &pLcd->oStatistic.busLock,
+                     interruptible ) )
+      return -ERESTARTSYS;
+
+   if( !pLcd->isRemoved )
+      return 0;
+
+   mutex_unlock( &pLcd->oBusMutex );
+   return -ENODEV;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Unlocks the access to the display-controller and wakes up the
+ *        tasks waiting for isIdle().
+ *
+ * Transfers still pending in the transport, e.g. the falling edge of en
+ * after the last read on a PCF8574, becomes finished before.
+ */
+static inline void unlockBus( LCD_OBJ_T* pLcd )
+{
+   if( pLcd->pTransport->flush != NULL )
+      pLcd->pTransport->flush( pLcd );
+   /*
+    * A bus-error, e.g. an exhausted busy-poll or a failed I2C-transfer,
+    * resets isInitialized. The init-work recovers the display, so the
+    * tasks waiting for isReady() don't wait forever.
+    */
+   if( pLcd->wasInitialized && !pLcd->isInitialized && !pLcd->isRemoved )
+      queue_work( global.poWorkqueue, &pLcd->oWorkQueue.oInit );
+   mutex_unlock( &pLcd->oBusMutex );
+   wake_up( &pLcd->oWaitQueue.queue );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Transfers a snapshot of the screen-model to the display.
+ * @note oBusMutex has to be held, oStateMutex becomes locked during
+ *       taking the snapshot only.
+ */
+static int flushDisplay( LCD_OBJ_T* pLcd )
+{
+   int ret;
+
+   lockState( pLcd );
+   pLcd->oFrame = pLcd->oScreen;
+   pLcd->frameDisplayState = pLcd->displayState;
+   pLcd->frameBytes = pLcd->bytesParsed;
+   pLcd->dirty = false;
+   unlockState( pLcd );
+
+   ret = lcdFlush( pLcd );
+   WRITE_ONCE( pLcd->lastFlush, jiffies );
+   latencyFlushed( pLcd, pLcd->frameBytes );
+   return ret;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Initializes the display-controller and transfers the screen-model
+ *        to it.
+ *
+ * The screen-model remains, so after a bus-error the display gets its
+ * content back. A reset of the screen-model by lcdResetScreen() is a
+ * matter of the caller.
+ * @note oBusMutex has to be held, oStateMutex becomes locked during
+ *       taking the snapshot only and not during the initialization which
+ *       takes more than 40 ms.
+ */
+static int initDisplay( LCD_OBJ_T* pLcd )
+{
+   int ret;
+
+   if( pLcd->wasInitialized )
+      pLcd->oStatistic.reinits++;
+   ret = lcdInit( pLcd );
+   pLcd->isInitialized = true;
+   pLcd->wasInitialized = true;
+   if( ret < 0 )
+      return ret;
+   return flushDisplay( pLcd );
+}
+
+#ifdef CONFIG_AN_LCD_CLK_CALIBRATE
+/*!----------------------------------------------------------------------------
+ * @brief Returns true if the bus-verification passes
+ *        LCD_CLK_CALIBRATE_PASSES times with the current CLK-delay.
+ * @note oBusMutex has to be held.
+ */
+static bool verifyClkDelay( LCD_OBJ_T* pLcd )
+{
+   const u64 pollTimeouts = pLcd->oStatistic.pollTimeouts;
+   int i;
+
+   for( i = 0; i < LCD_CLK_CALIBRATE_PASSES; i++ )
+   {
+      if( !lcdVerifyBus( pLcd ) )
+         return false;
+   }
+   return pLcd->oStatistic.pollTimeouts == pollTimeouts;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Searches binary the shortest CLK-delay at which the written
+ *        test-pattern can be read back and adds CONFIG_AN_LCD_CLK_MARGIN
+ *        percent to it.
+ *
+ * A failed verification can leave the controller in a undefined state,
+ * e.g. it could be lost the synchronization of the nibbles, therefore it
+ * becomes re-initialized with the last passed CLK-delay.
+ * @note oBusMutex has to be held, the screen-model remains untouched and
+ *       becomes transferred to the display by the following initDisplay().
+ */
+static void searchClkDelay( LCD_OBJ_T* pLcd )
+{
+   unsigned int passed = LCD_MAX_CLK_DELAY_NS;
+   unsigned int failed = 0;
+   u64 delay;
+
+   pLcd->clkDelayNs = passed;
+   lcdInit( pLcd );
+   if( !verifyClkDelay( pLcd ) )
+   {
+      /*
+       * E.g. a display without read-back or a bus-driver in one direction
+       * only, that's not an error, the default delay works anyway.
+       */
+      if( !pLcd->clkCalibrateWarned )
+      {
+         pLcd->clkCalibrateWarned = true;
+         WARNING_MESSAGE( DEVICE_BASE_FILE_NAME "%d: Calibration not possible, "
+                          "CLK-delay remains %u ns\n", pLcd->minor, passed );
+      }
+      return;
+   }
+
+   while( (passed - failed) > LCD_CLK_CALIBRATE_RESOLUTION_NS )
+   {
+      pLcd->clkDelayNs = failed + (passed - failed) / 2;
+      if( verifyClkDelay( pLcd ) )
+      {
+         passed = pLcd->clkDelayNs;
+         continue;
+      }
+      failed = pLcd->clkDelayNs;
+      pLcd->clkDelayNs = passed;
+      lcdInit( pLcd );
+   }
+
+   delay = passed + div_u64( (u64)passed * CONFIG_AN_LCD_CLK_MARGIN, 100 );
+   WRITE_ONCE( pLcd->clkDelayNs, min_t( u64, delay, LCD_MAX_CLK_DELAY_NS ) );
+   WRITE_ONCE( pLcd->clkSource, CLK_CALIBRATED );
+   INFO_MESSAGE( DEVICE_BASE_FILE_NAME "%d: Shortest CLK-delay %u ns, "
+                 "using %u ns\n", pLcd->minor, passed, pLcd->clkDelayNs );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Calibrates the CLK-delay by searchClkDelay().
+ *
+ * The test-patterns, address-commands and busy-reads of the calibration
+ * are no display-content, so they become taken out of the statistic
+ * again, otherwise they would falsify e.g. "Characters to display" and
+ * "Address commands saved".
+ * @note oBusMutex has to be held.
+ */
+static void calibrateClkDelay( LCD_OBJ_T* pLcd )
+{
+   LCD_STATISTIC_T* pStat = &pLcd->oStatistic;
+   const u64 chars        = pStat->chars;
+   const u64 addressCmds  = pStat->addressCmds;
+   const u64 addressSkips = pStat->addressSkips;
+   const u64 busyReads    = pStat->busyReads;
+   const u64 polls        = pStat->polls;
+   const u64 pollTimeouts = pStat->pollTimeouts;
+
+   searchClkDelay( pLcd );
+
+   pStat->chars        = chars;
+   pStat->addressCmds  = addressCmds;
+   pStat->addressSkips = addressSkips;
+   pStat->busyReads    = busyReads;
+   pStat->polls        = polls;
+   pStat->pollTimeouts = pollTimeouts;
+}
+#endif /* ifdef CONFIG_AN_LCD_CLK_CALIBRATE */
+
+/*!----------------------------------------------------------------------------
+ * @brief Returns the display-object of a opened device-file.
+ */
+static inline LCD_OBJ_T* getLcd( struct file* pInstance )
+{
+   return ((LCD_FILE_T*)pInstance->private_data)->pLcd;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Callback function becomes invoked by the function open() from the
+ *        user-space.
+ */
+static int onOpen( struct inode* pInode, struct file* pInstance )
+{
+   LCD_OBJ_T* pLcd;
+   LCD_FILE_T* pFile;
+
+   DEBUG_MESSAGE( ": Minor-number: %d\n", MINOR(pInode->i_rdev) );
+   BUG_ON( pInstance->private_data != NULL );
+   pFile = kmalloc( sizeof( LCD_FILE_T ), GFP_KERNEL );
+   if( pFile == NULL )
+      return -ENOMEM;
+
+   /*
+    * The object could be removed in the meantime, the reference keeps
+    * it till onClose().
+    */
+   mutex_lock( &global.oInstanceMutex );
+   pLcd = global.apLcd[iminor( pInode )];
+   if( pLcd != NULL )
+      kref_get( &pLcd->oRef );
+   mutex_unlock( &global.oInstanceMutex );
+   if( pLcd == NULL )
+   {
+      kfree( pFile );
+      return -ENODEV;
+   }
+
+   pFile->pLcd = pLcd;
+   pFile->readFlushCount = atomic_read( &pLcd->flushCount );
+   pFile->seenFlushCount = pFile->readFlushCount;
+   pInstance->private_data = pFile;
+#ifdef FMODE_NOWAIT
+   /*
+    * onWriteIter() respects IOCB_NOWAIT, so io_uring can write without
+    * a worker-thread.
+    */
+   pInstance->f_mode |= FMODE_NOWAIT;
+#endif
+   atomic_inc( &pLcd->openCount );
+   DEBUG_MESSAGE( ":   Open-counter: %d\n", 
+                  atomic_read( &pLcd->openCount ));
+
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Callback function becomes invoked by the function close() from the
+ *        user-space.
+ */
+static int onClose( struct inode *pInode, struct file* pInstance )
+{
+   LCD_OBJ_T* pLcd = getLcd( pInstance );
+
+   DEBUG_MESSAGE( ": Minor-number: %d\n", MINOR(pInode->i_rdev) );
+   atomic_dec( &pLcd->openCount );
+   DEBUG_MESSAGE( "   Open-counter: %d\n", 
+                  atomic_read( &pLcd->openCount ));
+   kfree( pInstance->private_data );
+   putLcdObject( pLcd );
+   return 0;
+}
+
+#ifdef CONFIG_AN_LCD_READBACK
+/*!----------------------------------------------------------------------------
+ * @brief Callback function becomes invoked by the function read() from the
+ *        user-space.
+ *
+ * The content becomes taken from the screen-model, so no bus-access is
+ * necessary. Only in the verify-mode (ioctl AN_DISPLAY_IOC_VERIFY_ON) the
+ * content becomes read back from the display-controller and compared with
+ * the RAM-copy of the display-controller.
+ * @note The kernel invokes onRead as many times till it returns 0 !!!
+ */
+static ssize_t onRead( struct file* pInstance,   /*!< @see include/linux/fs.h   */
+                       char __user* pBuffer,     /*!< buffer to fill with data */
+                       size_t len,               /*!< length of the buffer     */
+                       loff_t* pOffset )
+{
+   LCD_OBJ_T* pLcd = getLcd( pInstance );
+   char tmp[(MAX_X() * MAX_Y()) * 2 + MAX_Y() + 1];
+   char c;
+   ssize_t n, i;
+   int x, y;
+   int ret;
+   bool verify;
+   unsigned int mismatches = 0;
+
+   DEBUG_MESSAGE( ": len = %ld, offset = %lld\n", (long int)len, *pOffset );
+   DEBUG_ACCESSMODE( pInstance );
+
+   DEBUG_MESSAGE( "   Open-counter: %d\n", 
+                  atomic_read( &pLcd->openCount ));
+
+   if( READ_ONCE( pLcd->isRemoved ) )
+      return -ENODEV;
+
+   n = min( len, (sizeof(tmp)-1) );
+   n -= (*pOffset);
+   if( n <= 0 )
+      return n;
+
+   if( *pOffset == 0 )
+   {
+      /*
+       * Reading the content acknowledges the flushes for EPOLLIN and
+       * EPOLLPRI of poll().
+       */
+      ((LCD_FILE_T*)pInstance->private_data)->readFlushCount =
+                                           atomic_read( &pLcd->flushCount );
+      WRITE_ONCE( ((LCD_FILE_T*)pInstance->private_data)->seenFlushCount,
+                  atomic_read( &pLcd->flushCount ) );
+   }
+
+   /*
+    * The screen-model needs oStateMutex only, the verify-mode reads the
+    * display-controller and its RAM-copy under oBusMutex.
+    */
+   verify = pLcd->verifyRead;
+   if( verify )
+   {
+      if( !isIdle( pLcd ) && ((pInstance->f_flags & O_NONBLOCK) != 0) )
+         return -EAGAIN;
+      if( wait_event_interruptible( pLcd->oWaitQueue.queue, isIdle( pLcd ) ) )
+         return -ERESTARTSYS;
+      ret = lockBus( pLcd, true );
+      if( ret != 0 )
+         return ret;
+   }
+   else
+      lockState( pLcd );
+   DEBUG_MESSAGE( " n = %d\n", n );
+
+   i = 0;
+   for( y = 0; y < MAX_Y(); y++ )
+   {
+      for( x = 0; x < MAX_X(); x++ )
+      {
+         if( verify )
+         {
+            c = lcdReadChar( pLcd, x, y );
+            if( c != lcdGetShadowChar( pLcd, x, y ) )
+               mismatches++;
+         }
+         else
+            c = lcdGetScreenChar( pLcd, x, y );
+      #ifdef _CONVERT_CHAR8
+         lcdConvertBackChar8( &c );
+      #endif
+      #ifdef CONFIG_LCD_UNICODE
+         if( lcdConvertBackSpecialChar( &c ) )
+         {
+            if( i < (n-1) )
+               tmp[i++] = LCD_SPECIAL_CHAR_INTRUDUCHER;
+            else
+               goto L_LIMIT;
+         }
+       #ifndef CONFIG_LCD_NO_UMLAUT
+         else if( lcdConvertBackUmlaut( &c ) )
+         {
+            if( i < (n-1) )
+               tmp[i++] = LCD_UMLAUT_INTRUDUCHER;
+            else
+               goto L_LIMIT;
+         }
+       #endif /* ifndef CONFIG_LCD_NO_UMLAUT */
+      #endif /* ifdef CONFIG_LCD_UNICODE */
+         if( i < n )
+           tmp[i++] = c;
+         else
+           goto L_LIMIT;
+      }
+      if( i < n )
+         tmp[i++] = '\n';
+      else
+         break;
+   }
+
+L_LIMIT:
+   tmp[i] = '\0';
+   if( verify )
+   {
+      flushDisplay( pLcd );
+      unlockBus( pLcd );
+      if( mismatches != 0 )
+         ERROR_MESSAGE( ": %u character(s) of the display differ from RAM-copy!\n",
+                        mismatches );
+   }
+   else
+      unlockState( pLcd );
+
+   DEBUG_MESSAGE( " i = %d\n", i );
+   if( copy_to_user( pBuffer, tmp, i ) != 0 )
+   {
+      ERROR_MESSAGE( "copy_to_user\n" );
+      return -EFAULT;
+   }
+
+   (*pOffset) += n;
+   return i;
+   /* Number of bytes successfully read. */
+}
+#endif /* ifdef CONFIG_AN_LCD_READBACK */
+
+/*!----------------------------------------------------------------------------
+ * @brief Returns the delay in jiffies till one refresh-interval after the
+ *        previous flush.
+ */
+static unsigned long flushDelay( LCD_OBJ_T* pLcd )
+{
+   unsigned long next;
+   unsigned int refreshMs = READ_ONCE( pLcd->refreshMs );
+
+   if( refreshMs == 0 )
+      return 0;
+   next = READ_ONCE( pLcd->lastFlush ) + msecs_to_jiffies( refreshMs );
+   if( !time_before( jiffies, next ) )
+      return 0;
+   return next - jiffies;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Queues the flush of the screen-model, at the earliest one
+ *        refresh-interval after the previous flush.
+ *
+ * When the flush is already queued, the changes of this write becomes
+ * contained in it and the intermediate states are never shown.
+ * @note Becomes invoked under oWriteMutex.
+ */
+static void queueFlush( LCD_OBJ_T* pLcd )
+{
+   if( !queue_delayed_work( global.poWorkqueue, &pLcd->oWorkQueue.oWrite,
+                            flushDelay( pLcd ) ) )
+      pLcd->oStatistic.coalesced++;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Re-arms a queued flush after a change of the refresh-interval.
+ *
+ * The timer of the queued flush has been set with the previous interval,
+ * e.g. a flush waiting for a long interval would remain delayed after
+ * switching to 0.
+ */
+static void requeueFlush( LCD_OBJ_T* pLcd )
+{
+   if( delayed_work_pending( &pLcd->oWorkQueue.oWrite ) )
+      mod_delayed_work( global.poWorkqueue, &pLcd->oWorkQueue.oWrite,
+                        flushDelay( pLcd ) );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Copies the characters from the iterator directly in the free
+ *        space of the write-FIFO.
+ * @note oWriteMutex has to be held, so this is the single producer of
+ *       the FIFO.
+ * @return Number of copied bytes.
+ */
+static size_t writeFifo( LCD_OBJ_T* pLcd, struct iov_iter* pSource )
+{
+   struct scatterlist sg[2];
+   unsigned int nents, i;
+   size_t n, copied = 0;
+
+   /*
+    * The free space of the FIFO consists of at most two contiguous areas.
+    */
+   sg_init_table( sg, ARRAY_SIZE( sg ) );
+   nents = kfifo_dma_in_prepare( &pLcd->oFifo, sg, ARRAY_SIZE( sg ),
+                                 iov_iter_count( pSource ) );
+   for( i = 0; i < nents; i++ )
+   {
+      n = copy_from_iter( sg_virt( &sg[i] ), sg[i].length, pSource );
+      copied += n;
+      if( n < sg[i].length )
+         break;
+   }
+   /*
+    * The characters have to be visible for the parser before the
+    * FIFO-index announces them.
+    */
+   smp_wmb();
+   kfifo_dma_in_finish( &pLcd->oFifo, copied );
+   pLcd->oStatistic.bytesWritten += copied;
+   if( kfifo_len( &pLcd->oFifo ) > pLcd->oStatistic.fifoHighWater )
+      pLcd->oStatistic.fifoHighWater = kfifo_len( &pLcd->oFifo );
+   return copied;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Lets the escape-parser drain the write-FIFO.
+ *
+ * In the non-blocking mode nothing happens while oStateMutex is held
+ * by another task, the characters becomes parsed by it resp. by the next
+ * holder.
+ */
+static void drainFifo( LCD_OBJ_T* pLcd, bool nonBlocking )
+{
+   if( nonBlocking )
+   {
+      if( !trylockState( pLcd ) )
+         return;
+   }
+   else
+      lockState( pLcd );
+   unlockState( pLcd );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Callback function becomes invoked by the functions write(),
+ *        writev(), splice() and sendfile() from the user-space, as well
+ *        as by io_uring.
+ *
+ * The characters becomes copied from the iterator directly in the
+ * write-FIFO, using splice() the source are the pages of the pipe, so no
+ * further buffer is involved. After that the escape- and UTF-8-parser
+ * interprets them against the screen-model, that is CPU-work only without
+ * any bus-access. So the function returns with the final content and
+ * cursor-position and onWorkqueueWrite() transfers the changed cells to
+ * the display in the background.
+ * In the non-blocking mode the function doesn't wait for a flush taking
+ * its snapshot, the characters remain in the FIFO and becomes parsed by
+ * the next holder of oStateMutex. If the FIFO is full in this case the
+ * number of bytes which fits in becomes returned (short write).
+ */
+static ssize_t onWriteIter( struct kiocb* pIocb, struct iov_iter* pSource )
+{
+   struct file* pInstance = pIocb->ki_filp;
+   LCD_OBJ_T* pLcd = getLcd( pInstance );
+   bool nonBlocking;
+   size_t n, copied = 0;
+   u64 entryTime = ktime_get_ns();
+
+   DEBUG_MESSAGE( ": len = %ld\n", (long int)iov_iter_count( pSource ) );
+   DEBUG_ACCESSMODE( pInstance );
+   DEBUG_MESSAGE( "   Open-counter: %d\n", 
+                  atomic_read( &pLcd->openCount ));
+
+   nonBlocking = ((pInstance->f_flags & O_NONBLOCK) != 0) ||
+                 ((pIocb->ki_flags & IOCB_NOWAIT) != 0);
+   if( nonBlocking )
+   {
+      if( !mutex_trylock( &pLcd->oWriteMutex ) )
+         return -EAGAIN;
+   }
+   else
+   {
+      if( lockMeasured( &pLcd->oWriteMutex, &pLcd->oStatistic.writeLock, true ) )
+         return -ERESTARTSYS;
+   }
+   if( pLcd->isRemoved )
+   {
+      mutex_unlock( &pLcd->oWriteMutex );
+      return -ENODEV;
+   }
+
+   /*
+    * The FIFO becomes filled and drained by the parser in turn, so a
+    * write larger than the FIFO gets queued completely. Only in the
+    * non-blocking mode a FIFO which remains full ends the loop.
+    */
+   while( iov_iter_count( pSource ) > 0 )
+   {
+      if( kfifo_is_full( &pLcd->oFifo ) )
+      {
+         drainFifo( pLcd, nonBlocking );
+         if( kfifo_is_full( &pLcd->oFifo ) )
+            break;
+      }
+      n = writeFifo( pLcd, pSource );
+      if( n == 0 )
+         break;
+      copied += n;
+      drainFifo( pLcd, nonBlocking );
+   }
+   if( copied > 0 )
+   {
+      latencyWriteStamp( pLcd, entryTime );
+      queueFlush( pLcd );
+   }
+   mutex_unlock( &pLcd->oWriteMutex );
+
+   if( copied == 0 )
+   {
+      if( iov_iter_count( pSource ) == 0 )
+         return 0;
+      return nonBlocking? -EAGAIN : -EFAULT;
+   }
+
+   return copied;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Callback function becomes invoked by poll(), select() and epoll()
+ *        from the user-space.
+ *
+ * - EPOLLOUT: There is free space in the write-FIFO.
+ * - EPOLLIN:  The content of the display has changed since the last read()
+ *             resp. since opening.
+ * - EPOLLPRI: The display has been flushed since the last read() resp.
+ *             ioctl() of this device-file or since opening and all written
+ *             characters are on the display, so ioctl() and read() will
+ *             not block.
+ *
+ * Each change becomes signaled by the wait-queue oWaitQueue.
+ * @note The kernel invokes this function several times per wait, so it
+ *       doesn't change any state, the events become consumed by read()
+ *       resp. ioctl() only.
+ */
+static __poll_t onPoll( struct file* pInstance, poll_table* pPollTable )
+{
+   LCD_OBJ_T* pLcd = getLcd( pInstance );
+   LCD_FILE_T* pFile = pInstance->private_data;
+   __poll_t mask = 0;
+   int flushCount;
+
+   poll_wait( pInstance, &pLcd->oWaitQueue.queue, pPollTable );
+
+   if( READ_ONCE( pLcd->isRemoved ) )
+      return EPOLLERR | EPOLLHUP;
+
+   if( !kfifo_is_full( &pLcd->oFifo ) )
+      mask |= EPOLLOUT | EPOLLWRNORM;
+
+   flushCount = atomic_read( &pLcd->flushCount );
+#ifdef CONFIG_AN_LCD_READBACK
+   if( flushCount != READ_ONCE( pFile->readFlushCount ) )
+      mask |= EPOLLIN | EPOLLRDNORM;
+#endif
+   if( (flushCount != READ_ONCE( pFile->seenFlushCount )) && isIdle( pLcd ) )
+      mask |= EPOLLPRI;
+
+   return mask;
+}
+
+/*=========================== ioctl handling ================================*/
+/*!----------------------------------------------------------------------------
+ * @brief Resets the screen-model only, the display-controller becomes
+ *        initialized by onIoctrl() after releasing oStateMutex.
+ */
+static long onIoctlReset( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   lcdResetScreen( pLcd );
+   pLcd->isInitialized = false;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlScrollUp( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   if( lcdScrollUp( pLcd ) < 0 )
+      return -EFAULT;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlScrollDown( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   if( lcdScrollDown( pLcd ) < 0 )
+      return -EFAULT;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlLoadDefaultCgRam( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   lcdLoadPredefinedExtraCharacters( pLcd );
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlWriteCgRam( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   LCD_CGRAM_T cgRamBuffer;
+
+   if( copy_from_user( &cgRamBuffer, (void*)arg, sizeof( cgRamBuffer ) ) != 0 )
+   {
+      ERROR_MESSAGE( ": copy_from_user failed\n" );
+      return -EFAULT;
+   }
+
+   if( lcdLoadExtraCharP( pLcd, cgRamBuffer.content, cgRamBuffer.address ) < 0 )
+   {
+      ERROR_MESSAGE( ": writing of CG-RAM failed\n" );
+      return -EFAULT;
+   }
+
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlAutoScrollOn( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   lcdEnableAutoScroll( pLcd );
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlAutoScrollOff( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   lcdDisableAutoScroll( pLcd );
+   return 0;
+}
+
+#ifdef CONFIG_AN_LCD_READBACK
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlVerifyOn( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   if( pLcd->writeOnly )
+   {
+      ERROR_MESSAGE( ": Read back is not possible in write-only mode!\n" );
+      return -EOPNOTSUPP;
+   }
+   pLcd->verifyRead = true;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlVerifyOff( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   pLcd->verifyRead = false;
+   return 0;
+}
+#endif /* ifdef CONFIG_AN_LCD_READBACK */
+
+/*!----------------------------------------------------------------------------
+ * @brief Sets the refresh-interval in milliseconds, 0 switches the frame
+ *        pacing off.
+ */
+static long onIoctlSetRefresh( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   unsigned int refreshMs;
+
+   if( get_user( refreshMs, (unsigned int __user*)arg ) != 0 )
+      return -EFAULT;
+   if( refreshMs > LCD_MAX_REFRESH_MS )
+   {
+      ERROR_MESSAGE( ": Refresh-interval of %u ms is out of range of %u ms\n",
+                     refreshMs, LCD_MAX_REFRESH_MS );
+      return -EINVAL;
+   }
+   WRITE_ONCE( pLcd->refreshMs, refreshMs );
+   requeueFlush( pLcd );
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlGetRefresh( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   if( put_user( pLcd->refreshMs, (unsigned int __user*)arg ) != 0 )
+      return -EFAULT;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlDisplayOff( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   if( lcdOff( pLcd ) < 0 )
+      return -EFAULT;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static long onIoctlDisplayOn( LCD_OBJ_T* pLcd, unsigned long arg )
+{
+   if( lcdOn( pLcd ) < 0 )
+      return -EFAULT;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+typedef struct
+{
+   char*        name;
+   unsigned int number;
+   long (*function)( LCD_OBJ_T* pLcd, unsigned long arg );
+   unsigned int flags;
+} IOC_INFO_T;
+
+/*!
+ * @defgroup IOC_FLAGS Locking requirements of the ioctl-commands
+ * @{
+ */
+/*! @brief Changes the state only, runs concurrently with a flush. */
+#define IOC_STATE 0x00
+/*! @brief The changed screen-model becomes flushed afterwards. */
+#define IOC_FLUSH 0x01
+/*! @brief The command itself accesses the display-controller. */
+#define IOC_BUS   (0x02 | IOC_FLUSH)
+/*! @} */
+
+#define IOCTL_ITEM( n, f, flags ) { #n, n, f, flags }
+
+/*!
+ * @todo Ioctl-dummy handling of TCGETS and TCSETS defined in "termios.h"
+ */
+
+const static IOC_INFO_T mg_ioctlList[] =
+{
+   IOCTL_ITEM( AN_DISPLAY_IOC_RESET,              onIoctlReset,            IOC_BUS ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_SCROLL_UP,          onIoctlScrollUp,         IOC_FLUSH ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_SCROLL_DOWN,        onIoctlScrollDown,       IOC_FLUSH ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_LOAD_DEFAULT_CGRAM, onIoctlLoadDefaultCgRam, IOC_BUS ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_WRITE_CGRAM,        onIoctlWriteCgRam,       IOC_BUS ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_AUTOSCROLL_ON,      onIoctlAutoScrollOn,     IOC_STATE ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_AUTOSCROLL_OFF,     onIoctlAutoScrollOff,    IOC_STATE ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_OFF,                onIoctlDisplayOff,       IOC_FLUSH ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_ON,                 onIoctlDisplayOn,        IOC_FLUSH ),
+#ifdef CONFIG_AN_LCD_READBACK
+   IOCTL_ITEM( AN_DISPLAY_IOC_VERIFY_ON,          onIoctlVerifyOn,         IOC_STATE ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_VERIFY_OFF,         onIoctlVerifyOff,        IOC_STATE ),
+#endif
+   IOCTL_ITEM( AN_DISPLAY_IOC_SET_REFRESH,        onIoctlSetRefresh,       IOC_STATE ),
+   IOCTL_ITEM( AN_DISPLAY_IOC_GET_REFRESH,        onIoctlGetRefresh,       IOC_STATE ),
+   { NULL, 0, NULL, 0 }
+};
+
+/*!----------------------------------------------------------------------------
+ * @brief Callback function becomes invoked by the function ioctrl() from the
+ *        user-space.
+ *
+ * Each command becomes executed after the preceding writes. Commands which
+ * change the state only (IOC_STATE) don't wait for a running flush, the
+ * other commands transfer the changes to the display before returning.
+ */
+static long onIoctrl( struct file* pInstance,
+                      unsigned int cmd,
+                      unsigned long arg )
+{
+   LCD_OBJ_T* pLcd = getLcd( pInstance );
+   int ret;
+   const IOC_INFO_T* pCurrentItem;
+   bool busLocked;
+   u64 start;
 
    DEBUG_MESSAGE( ": cmd = 0x%08X arg = 0x%08lX\n", cmd, arg );
    DEBUG_ACCESSMODE( pInstance );
    DEBUG_MESSAGE( "   Open-counter: %d\n",
-                   atomic_read( &global.oLcd.openCount ));
+                   atomic_read( &pLcd->openCount ));
+
+   for( pCurrentItem = mg_ioctlList; pCurrentItem->function != NULL; pCurrentItem++ )
+   {
+      if( pCurrentItem->number == cmd )
+         break;
+   }
+   if( pCurrentItem->function == NULL )
+   {
+      ERROR_MESSAGE( ": Unknown ioctl-command: 0x%08X\n", cmd );
+      return -EINVAL;
+   }
+
+   if( (pInstance->f_flags & O_NONBLOCK) != 0 )
+   {
+      if( ((pCurrentItem->flags & IOC_FLUSH) != 0)? !isIdle( pLcd ) :
+                                                     !isReady( pLcd ) )
+         return -EAGAIN;
+   }
+   else if( wait_event_interruptible( pLcd->oWaitQueue.queue, isReady( pLcd ) ) )
+      return -ERESTARTSYS;
+   if( READ_ONCE( pLcd->isRemoved ) )
+      return -ENODEV;
+
+   DEBUG_MESSAGE( ": execute ioctl-command: %s\n", pCurrentItem->name );
+   start = ktime_get_ns();
+   busLocked = ((pCurrentItem->flags & IOC_BUS) == IOC_BUS);
+   if( busLocked )
+   {
+      ret = lockBus( pLcd, true );
+      if( ret != 0 )
+         return ret;
+   }
+
+   lockState( pLcd );
+   ret = pCurrentItem->function( pLcd, arg );
+   unlockState( pLcd );
+
+   if( ret < 0 )
+      ERROR_MESSAGE( ": executing of ioctl-command %s failed!\n",
+                     pCurrentItem->name );
+   else if( (pCurrentItem->flags & IOC_FLUSH) != 0 )
+   {
+      /*
+       * The state is already changed, so the flush may not be interrupted.
+       */
+      if( !busLocked )
+         busLocked = (lockBus( pLcd, false ) == 0);
+      if( !busLocked )
+         ret = -ENODEV;
+      else if( (pLcd->isInitialized? flushDisplay( pLcd ) :
+                                     initDisplay( pLcd )) < 0 )
+         ret = -EFAULT;
+      else
+         atomic_inc( &pLcd->flushCount );
+   }
+   if( busLocked )
+      unlockBus( pLcd );
+
+   /*
+    * The caller has waited for the flushes till now, so they are no
+    * event for its poll() anymore, e.g. AN_DISPLAY_IOC_GET_REFRESH
+    * acknowledges EPOLLPRI.
+    */
+   if( ret >= 0 )
+      WRITE_ONCE( ((LCD_FILE_T*)pInstance->private_data)->seenFlushCount,
+                  atomic_read( &pLcd->flushCount ) );
+
+   latencyIoctl( pLcd, cmd, ktime_get_ns() - start );
+   return ret;
+}
+
+/*===========================================================================*/
+/*!----------------------------------------------------------------------------
+ */
+static struct file_operations global_fops =
+{
+  .owner          = THIS_MODULE,
+  .open           = onOpen,
+  .release        = onClose,
+#ifdef CONFIG_AN_LCD_READBACK
+  .read           = onRead,
+#endif
+  .write_iter     = onWriteIter,
+  .splice_write   = iter_file_splice_write,
+  .poll           = onPoll,
+  .unlocked_ioctl = onIoctrl
+};
+/* Device file operations end ************************************************/
+
+/*!----------------------------------------------------------------------------
+ * @brief Returns the elapsed time since start for the event anLcd_work_end,
+ *        resp. 0 if the event became enabled after the begin of the
+ *        work-item, so no start-time was recorded.
+ */
+static inline u64 traceElapsed( u64 start )
+{
+   return (start != 0)? ktime_get_ns() - start : 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static void onWorkqueueInit( struct work_struct* poWork )
+{
+   LCD_OBJ_T* pLcd = container_of( poWork, LCD_OBJ_T, oWorkQueue.oInit );
+   u64 start = 0;
+
+   DEBUG_MESSAGE( "\n" );
+   if( trace_anLcd_work_begin_enabled() || trace_anLcd_work_end_enabled() )
+   {
+      start = ktime_get_ns();
+      trace_anLcd_work_begin( pLcd->minor, ANLCD_TRACE_WORK_INIT, 0, 0 );
+   }
+   /*
+    * The write-work could be faster and has initialized the display already.
+    */
+   if( lockBus( pLcd, false ) != 0 )
+      return;
+   if( !pLcd->isInitialized )
+   {
+   #ifdef CONFIG_AN_LCD_CLK_CALIBRATE
+      /*
+       * The calibration needs to read back, so it's not possible
+       * in write-only mode. Transports without CLK-delay, e.g. the
+       * I2C-bus of a PCF8574, are pacing the edges by themselves.
+       */
+      if( (pLcd->clkSource == CLK_DEFAULT) && !pLcd->writeOnly &&
+          pLcd->pTransport->hasClkDelay )
+         calibrateClkDelay( pLcd );
+   #endif
+      initDisplay( pLcd );
+   }
+   unlockBus( pLcd );
+   if( trace_anLcd_work_end_enabled() )
+      trace_anLcd_work_end( pLcd->minor, ANLCD_TRACE_WORK_INIT, 0,
+                            traceElapsed( start ) );
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static void onWorkqueueWrite( struct work_struct* poWork )
+{
+   LCD_OBJ_T* pLcd = container_of( to_delayed_work( poWork ), LCD_OBJ_T,
+                                   oWorkQueue.oWrite );
+   unsigned int bytes;
+   u64 start = 0;
+   DEBUG_MESSAGE( "\n" );
+
+   if( trace_anLcd_work_begin_enabled() || trace_anLcd_work_end_enabled() )
+   {
+      start = ktime_get_ns();
+      trace_anLcd_work_begin( pLcd->minor, ANLCD_TRACE_WORK_WRITE,
+                              kfifo_len( &pLcd->oFifo ), 0 );
+   }
+
+   /*
+    * The characters are already in the screen-model, resp. becomes parsed
+    * from the write-FIFO by the snapshot, so only the changed cells
+    * becomes transferred. Writes during a flush resp. during the
+    * refresh-interval queue the work again and becomes coalesced in the
+    * next flush, so stale intermediate frames are dropped.
+    */
+   if( lockBus( pLcd, false ) != 0 )
+      return;
+   /*
+    * After a bus-error the display becomes re-initialized and gets the
+    * whole screen-model, see unlockBus().
+    */
+   bytes = pLcd->frameBytes;
+   if( !pLcd->isInitialized )
+   {
+      initDisplay( pLcd );
+      atomic_inc( &pLcd->flushCount );
+   }
+   else if( READ_ONCE( pLcd->dirty ) || !kfifo_is_empty( &pLcd->oFifo ) )
+   {
+      flushDisplay( pLcd );
+      atomic_inc( &pLcd->flushCount );
+   }
+   bytes = pLcd->frameBytes - bytes;
+   unlockBus( pLcd );
+
+   if( trace_anLcd_work_end_enabled() )
+      trace_anLcd_work_end( pLcd->minor, ANLCD_TRACE_WORK_WRITE, bytes,
+                            traceElapsed( start ) );
+}
+
+
+/* Process-file-system begin *************************************************/
+#ifdef CONFIG_PROC_FS
+/*-----------------------------------------------------------------------------
+ */
+static void procShowLock( struct seq_file* pSeqFile, const char* name,
+                          LCD_LOCK_STATISTIC_T* pStat )
+{
+   seq_printf( pSeqFile, "%s-lock contentions: %llu, waited %llu us\n",
+               name, pStat->contended, div64_u64( pStat->waitNs, NSEC_PER_USEC ) );
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static void procShowLcd( struct seq_file* pSeqFile, LCD_OBJ_T* pLcd )
+{
+   int i;
+
+   seq_printf( pSeqFile, "\n/dev/" DEVICE_BASE_FILE_NAME "%d: %dx%d\n",
+               pLcd->minor, pLcd->maxX, pLcd->maxY );
+
+   for( i = 0; i < ARRAY_SIZE( pLcd->port.list ); i++ )
+   {
+      if( !pLcd->port.list[i]->initialized )
+         continue;
+      seq_printf( pSeqFile, "GPIO %02d: %s = %s\n",
+                  pLcd->port.list[i]->number,
+                  pLcd->port.list[i]->name,
+                 (gpio_get_value( pLcd->port.list[i]->number ) != 0)?
+                 "high" : "low" );
+   }
+
+   seq_printf( pSeqFile, "Auto scroll: %s\n",
+               lcdIsAutoScroll( pLcd )? "enabled" : "disabled" );
+   seq_printf( pSeqFile, "Bus mode: %s\n",
+               pLcd->writeOnly? "write-only (timed)" : "read/write (busy-flag)" );
+   seq_printf( pSeqFile, "Transport: %s\n", pLcd->pTransport->name );
+   seq_printf( pSeqFile, "Data bus: %u bit\n", pLcd->port.dataCount );
+   seq_printf( pSeqFile, "Controller: %s\n", pLcd->pTiming->name );
+   pLcd->pTransport->show( pLcd, pSeqFile );
+   seq_printf( pSeqFile, "Write FIFO: %u of %u bytes\n",
+               kfifo_len( &pLcd->oFifo ), kfifo_size( &pLcd->oFifo ) );
+#ifdef CONFIG_AN_LCD_READBACK
+   seq_printf( pSeqFile, "Read verify: %s\n",
+               pLcd->verifyRead? "enabled" : "disabled" );
+#endif
+   seq_printf( pSeqFile, "Bytes written: %llu\n",
+               pLcd->oStatistic.bytesWritten );
+   seq_printf( pSeqFile, "Characters to display: %llu\n",
+               pLcd->oStatistic.chars );
+   seq_printf( pSeqFile, "Address commands: %llu\n",
+               pLcd->oStatistic.addressCmds );
+   seq_printf( pSeqFile, "Address commands saved: %llu\n",
+               pLcd->oStatistic.addressSkips );
+   seq_printf( pSeqFile, "Busy-flag reads: %llu\n",
+               pLcd->oStatistic.busyReads );
+   seq_printf( pSeqFile, "Busy-flag polls: %llu\n",
+               pLcd->oStatistic.polls );
+   seq_printf( pSeqFile, "Poll timeouts: %llu\n",
+               pLcd->oStatistic.pollTimeouts );
+   seq_printf( pSeqFile, "Reinitializations: %llu\n",
+               pLcd->oStatistic.reinits );
+   seq_printf( pSeqFile, "FIFO high-water mark: %u bytes\n",
+               pLcd->oStatistic.fifoHighWater );
+   seq_printf( pSeqFile, "Refresh interval: %u ms\n",
+               pLcd->refreshMs );
+   seq_printf( pSeqFile, "Coalesced writes: %llu\n",
+               pLcd->oStatistic.coalesced );
+   seq_printf( pSeqFile, "Busy-wait time: %llu us\n",
+               div_u64( pLcd->oStatistic.delayNs, NSEC_PER_USEC ) );
+   seq_printf( pSeqFile, "Sleep time: %llu us\n",
+               div_u64( pLcd->oStatistic.sleepNs, NSEC_PER_USEC ) );
+   procShowLock( pSeqFile, "Write", &pLcd->oStatistic.writeLock );
+   procShowLock( pSeqFile, "State", &pLcd->oStatistic.stateLock );
+   procShowLock( pSeqFile, "Bus", &pLcd->oStatistic.busLock );
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static int procOnOpen( struct seq_file* pSeqFile, void* pValue )
+{
+   int i;
+   const IOC_INFO_T* pCurrentItem;
+
+   DEBUG_MESSAGE( "\n" );
+   seq_printf( pSeqFile, KBUILD_MODNAME " Version: " __VERSION "\n" );
+
+   mutex_lock( &global.oInstanceMutex );
+   for( i = 0; i < ARRAY_SIZE( global.apLcd ); i++ )
+   {
+      if( global.apLcd[i] != NULL )
+         procShowLcd( pSeqFile, global.apLcd[i] );
+   }
+   mutex_unlock( &global.oInstanceMutex );
+
+   seq_printf( pSeqFile, "\nValid commands for ioctl():\n" ); 
+
+   for( pCurrentItem = mg_ioctlList; pCurrentItem->function != NULL; pCurrentItem++ )
+   {
+      seq_printf( pSeqFile, "%s:\t0x%08X\n",
+                  pCurrentItem->name,
+                  pCurrentItem->number );
+   }
+   return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static int _procOnOpen( struct inode* pInode, struct file *pFile )
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 0, 0)
+   return single_open( pFile, procOnOpen, NULL );
+#else
+   return single_open( pFile, procOnOpen, PDE_DATA( pInode ) );
+#endif
+}
+
+/*-----------------------------------------------------------------------------
+ * Measures how many level-changes per second are possible on the pin rs.
+ * Changing rs without a pulse on en has no effect on the display.
+ */
+#define TOGGLE_TEST_COUNT 10000
+static void measureToggleRate( LCD_OBJ_T* pLcd )
+{
+   int i;
+   u64 ns;
+   ktime_t start;
+
+   start = ktime_get();
+   for( i = 0; i < TOGGLE_TEST_COUNT; i++ )
+      setLcdPin( &pLcd->port.rs, i & 1 );
+   ns = ktime_to_ns( ktime_sub( ktime_get(), start ) );
+   if( ns == 0 )
+      ns = 1;
+   INFO_MESSAGE( DEVICE_BASE_FILE_NAME "%d: %d toggles in %llu ns: %llu toggles/s, drive: %s\n",
+                 pLcd->minor, TOGGLE_TEST_COUNT, ns,
+                 div64_u64( (u64)TOGGLE_TEST_COUNT * NSEC_PER_SEC, ns ),
+                 getDriveStr( pLcd->port.rs.drive ) );
+}
+
+/*-----------------------------------------------------------------------------
+ * The command becomes applied to all displays.
+ */
+static ssize_t procOnWrite( struct file* seq, const char __user* pData,
+                            size_t len, loff_t* pPos )
+{
+   int i, err;
+   LCD_OBJ_T* pLcd;
+   ssize_t ret = len;
+   char command;
+#ifdef CONFIG_DEBUG_AN_LCD
+   BYTE addrOut;
+#endif
+
+   DEBUG_MESSAGE( "\n" );
+   if( len == 0 )
+      return 0;
+   if( get_user( command, pData ) )
+      return -EFAULT;
+   if( mutex_lock_interruptible( &global.oInstanceMutex ) )
+      return -ERESTARTSYS;
+
+   for( i = 0; i < ARRAY_SIZE( global.apLcd ); i++ )
+   {
+      pLcd = global.apLcd[i];
+      if( pLcd == NULL )
+         continue;
+      if( wait_event_interruptible( pLcd->oWaitQueue.queue, isIdle( pLcd ) ) )
+      {
+         ret = -ERESTARTSYS;
+         break;
+      }
+      err = lockBus( pLcd, true );
+      if( err == -ENODEV )
+         continue;
+      if( err != 0 )
+      {
+         ret = err;
+         break;
+      }
+
+      if( command == '1' )
+      {
+         lockState( pLcd );
+         lcdResetScreen( pLcd );
+         unlockState( pLcd );
+         initDisplay( pLcd );
+      }
+      if( (command == '3') && pLcd->pTransport->hasClkDelay )
+         measureToggleRate( pLcd );
+
+   #ifdef CONFIG_DEBUG_AN_LCD
+      /* IO-Test */
+      if( command == '2' ) 
+      {
+         for( addrOut = 0; addrOut <= 0x0F; addrOut++ )
+            lcdReadChar( pLcd, addrOut % MAX_X(), 0 );
+         flushDisplay( pLcd );
+      }
+   #endif
+      unlockBus( pLcd );
+   }
+
+   mutex_unlock( &global.oInstanceMutex );
+   return ret;
+}
+
+/*-----------------------------------------------------------------------------
+ */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0)
+static const struct proc_ops global_procFileOps =
+{
+  .proc_open    = _procOnOpen,
+  .proc_read    = seq_read,
+  .proc_write   = procOnWrite,
+  .proc_lseek   = seq_lseek,
+  .proc_release = single_release
+};
+#else
+static const struct file_operations global_procFileOps =
+{
+  .owner   = THIS_MODULE,
+  .open    = _procOnOpen,
+  .read    = seq_read,
+  .write   = procOnWrite,
+  .llseek  = seq_lseek,
+  .release = single_release
+};
+#endif
 
-   if( global.oWaitQueue.bussy && ((pInstance->f_flags & O_NONBLOCK) != 0) )
-      return -EAGAIN;
-   if( wait_event_interruptible( global.oWaitQueue.queue, !global.oWaitQueue.bussy ) )
-      return -ERESTARTSYS;
-   global.oWaitQueue.bussy = true;
+#endif /* ifdef CONFIG_PROC_FS */
+/* Process-file-system end ***************************************************/
 
-   for( pCurrentItem = mg_ioctlList; pCurrentItem->function != NULL; pCurrentItem++ )
+/* Debug-file-system begin ***************************************************/
+#ifdef CONFIG_DEBUG_FS
+/*-----------------------------------------------------------------------------
+ * @brief Copies a histogram under stampLock, so the number of samples and
+ *        the buckets of the copy match each other and a concurrent reset
+ *        can't clear the samples between the test and the division.
+ */
+static void debugFsCopyHistogram( LCD_OBJ_T* pLcd, LCD_HISTOGRAM_T* pDest,
+                                  const LCD_HISTOGRAM_T* pSource )
+{
+   spin_lock( &pLcd->oLatency.stampLock );
+   *pDest = *pSource;
+   spin_unlock( &pLcd->oLatency.stampLock );
+}
+
+/*-----------------------------------------------------------------------------
+ * @brief Shows a copy of a histogram made by debugFsCopyHistogram().
+ */
+static void debugFsShowHistogram( struct seq_file* pSeqFile,
+                                  const LCD_HISTOGRAM_T* pHist )
+{
+   int i;
+   unsigned long sum = 0;
+
+   seq_printf( pSeqFile, "samples: %lu\n", pHist->samples );
+   if( pHist->samples == 0 )
+      return;
+   seq_printf( pSeqFile, "average: %llu ns\n",
+               div64_u64( pHist->sum, pHist->samples ) );
+   seq_printf( pSeqFile, "maximum: %llu ns\n", pHist->max );
+   for( i = 0; i < ARRAY_SIZE( pHist->count ); i++ )
    {
-      if( pCurrentItem->number != cmd )
+      if( pHist->count[i] == 0 )
          continue;
-      DEBUG_MESSAGE( ": execute ioctl-command: %s\n", pCurrentItem->name );
-      ret = pCurrentItem->function( arg );
-      if( ret < 0 )
-         ERROR_MESSAGE( ": executing of ioctl-command %s failed!\n",
-                        pCurrentItem->name );
-      break;
-   }
-   if( pCurrentItem->function == NULL )
-   {
-      ERROR_MESSAGE( ": Unknown ioctl-command: 0x%08X\n", cmd );
-      ret = -EINVAL;
+      sum += pHist->count[i];
+      seq_printf( pSeqFile, "%12llu .. %12llu ns: %10lu %3lu%%\n",
+                  (i == 0)? 0ULL : (1ULL << i), (2ULL << i) - 1,
+                  pHist->count[i], (sum * 100) / pHist->samples );
    }
+}
 
-   global.oWaitQueue.bussy = false;
-   return ret;
+/*-----------------------------------------------------------------------------
+ */
+static int debugFsOnShowWriteHistogram( struct seq_file* pSeqFile, void* pValue )
+{
+   LCD_OBJ_T* pLcd = pSeqFile->private;
+   LCD_HISTOGRAM_T oHist;
+
+   debugFsCopyHistogram( pLcd, &oHist, &pLcd->oLatency.write );
+   debugFsShowHistogram( pSeqFile, &oHist );
+   return 0;
 }
 
-/*===========================================================================*/
-/*!----------------------------------------------------------------------------
+/*-----------------------------------------------------------------------------
  */
-static struct file_operations global_fops =
+static int debugFsOnOpenWriteHistogram( struct inode* pInode, struct file* pFile )
 {
-  .owner          = THIS_MODULE,
-  .open           = onOpen,
-  .release        = onClose,
-#ifdef CONFIG_AN_LCD_READBACK
-  .read           = onRead,
-#endif
-  .write          = onWrite,
-  .unlocked_ioctl = onIoctrl
+   return single_open( pFile, debugFsOnShowWriteHistogram, pInode->i_private );
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static const struct file_operations mg_debugFsWriteHistogramOps =
+{
+  .owner   = THIS_MODULE,
+  .open    = debugFsOnOpenWriteHistogram,
+  .read    = seq_read,
+  .llseek  = seq_lseek,
+  .release = single_release
 };
-/* Device file operations end ************************************************/
 
-/*!----------------------------------------------------------------------------
+/*-----------------------------------------------------------------------------
  */
-static void onWorkqueueInit( struct work_struct* poWork )
+static int debugFsOnShowBusHistogram( struct seq_file* pSeqFile, void* pValue )
 {
-   DEBUG_MESSAGE( "\n" );
-   lcdInit();
-   global.oLcd.isInitialized = true;
-   global.oWaitQueue.bussy = false;
-   wake_up_interruptible( &global.oWaitQueue.queue );
+   LCD_OBJ_T* pLcd = pSeqFile->private;
+   LCD_HISTOGRAM_T oHist;
+
+   debugFsCopyHistogram( pLcd, &oHist, &pLcd->oLatency.bus );
+   debugFsShowHistogram( pSeqFile, &oHist );
+   return 0;
 }
 
-/*!----------------------------------------------------------------------------
+/*-----------------------------------------------------------------------------
  */
-static void onWorkqueueWrite( struct work_struct* poWork )
+static int debugFsOnOpenBusHistogram( struct inode* pInode, struct file* pFile )
 {
-   size_t i;
-   u8* pData = global.oBuffer.pData;
-   DEBUG_MESSAGE( "\n" );
+   return single_open( pFile, debugFsOnShowBusHistogram, pInode->i_private );
+}
 
-   if( !global.oLcd.isInitialized )
-   {
-      lcdInit();
-      global.oLcd.isInitialized = true;
-   }
+/*-----------------------------------------------------------------------------
+ */
+static const struct file_operations mg_debugFsBusHistogramOps =
+{
+  .owner   = THIS_MODULE,
+  .open    = debugFsOnOpenBusHistogram,
+  .read    = seq_read,
+  .llseek  = seq_lseek,
+  .release = single_release
+};
+
+/*-----------------------------------------------------------------------------
+ * @brief Shows the histograms of all ioctl-commands which has been executed.
+ */
+static int debugFsOnShowIoctlHistogram( struct seq_file* pSeqFile, void* pValue )
+{
+   LCD_OBJ_T* pLcd = pSeqFile->private;
+   LCD_HISTOGRAM_T oHist;
+   const IOC_INFO_T* pCurrentItem;
 
-   for( i = 0; i < global.oBuffer.len; i++ )
+   for( pCurrentItem = mg_ioctlList; pCurrentItem->function != NULL; pCurrentItem++ )
    {
-      if( *pData == '\0' )
-         break;
-      lcdPutch( *pData );
-      pData++;
+      debugFsCopyHistogram( pLcd, &oHist,
+                            &pLcd->oLatency.ioctl[_IOC_NR( pCurrentItem->number )] );
+      if( oHist.samples == 0 )
+         continue;
+      seq_printf( pSeqFile, "%s:\n", pCurrentItem->name );
+      debugFsShowHistogram( pSeqFile, &oHist );
    }
+   return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static int debugFsOnOpenIoctlHistogram( struct inode* pInode, struct file* pFile )
+{
+   return single_open( pFile, debugFsOnShowIoctlHistogram, pInode->i_private );
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static const struct file_operations mg_debugFsIoctlHistogramOps =
+{
+  .owner   = THIS_MODULE,
+  .open    = debugFsOnOpenIoctlHistogram,
+  .read    = seq_read,
+  .llseek  = seq_lseek,
+  .release = single_release
+};
+
+/*-----------------------------------------------------------------------------
+ * @brief Clears histograms under stampLock, the producers take it as well.
+ */
+static void debugFsResetHistogram( LCD_OBJ_T* pLcd, LCD_HISTOGRAM_T* pHist,
+                                   size_t size )
+{
+   spin_lock( &pLcd->oLatency.stampLock );
+   memset( pHist, 0, size );
+   spin_unlock( &pLcd->oLatency.stampLock );
+}
+
+/*-----------------------------------------------------------------------------
+ * @brief Each write in the reset-file clears the write-histogram.
+ */
+static ssize_t debugFsOnWriteWriteReset( struct file* pFile,
+                                         const char __user* pData,
+                                         size_t len, loff_t* pOffset )
+{
+   LCD_OBJ_T* pLcd = file_inode( pFile )->i_private;
 
-   global.oWaitQueue.bussy = false;
-   wake_up_interruptible( &global.oWaitQueue.queue );
+   debugFsResetHistogram( pLcd, &pLcd->oLatency.write,
+                          sizeof( pLcd->oLatency.write ) );
+   return len;
 }
 
+/*-----------------------------------------------------------------------------
+ */
+static const struct file_operations mg_debugFsWriteResetOps =
+{
+  .owner   = THIS_MODULE,
+  .write   = debugFsOnWriteWriteReset
+};
 
-/* Process-file-system begin *************************************************/
-#ifdef CONFIG_PROC_FS
 /*-----------------------------------------------------------------------------
+ * @brief Each write in the reset-file clears the bus-histogram.
  */
-static int procOnOpen( struct seq_file* pSeqFile, void* pValue )
+static ssize_t debugFsOnWriteBusReset( struct file* pFile,
+                                       const char __user* pData,
+                                       size_t len, loff_t* pOffset )
+{
+   LCD_OBJ_T* pLcd = file_inode( pFile )->i_private;
+
+   debugFsResetHistogram( pLcd, &pLcd->oLatency.bus,
+                          sizeof( pLcd->oLatency.bus ) );
+   return len;
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static const struct file_operations mg_debugFsBusResetOps =
+{
+  .owner   = THIS_MODULE,
+  .write   = debugFsOnWriteBusReset
+};
+
+/*-----------------------------------------------------------------------------
+ * @brief Each write in the reset-file clears the histograms of all
+ *        ioctl-commands.
+ */
+static ssize_t debugFsOnWriteIoctlReset( struct file* pFile,
+                                         const char __user* pData,
+                                         size_t len, loff_t* pOffset )
+{
+   LCD_OBJ_T* pLcd = file_inode( pFile )->i_private;
+
+   debugFsResetHistogram( pLcd, pLcd->oLatency.ioctl,
+                          sizeof( pLcd->oLatency.ioctl ) );
+   return len;
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static const struct file_operations mg_debugFsIoctlResetOps =
+{
+  .owner   = THIS_MODULE,
+  .write   = debugFsOnWriteIoctlReset
+};
+
+#ifdef CONFIG_AN_LCD_BUS_CAPTURE
+/*!
+ * @brief Copy of the capture ring-buffer made by opening the VCD-file.
+ */
+typedef struct
+{
+   unsigned int       count;
+   LCD_CAPTURE_ITEM_T aItem[];
+} CAPTURE_COPY_T;
+
+/*!
+ * @brief Names and VCD-identifiers of the captured signals.
+ */
+static const struct
+{
+   const char*  name;
+   char         id;
+   unsigned int mask;
+} mg_vcdSignals[] =
+{
+   { TS(DT_TAG_RS), '!', LCD_CAPTURE_RS },
+   { TS(DT_TAG_RW), '"', LCD_CAPTURE_RW },
+   { TS(DT_TAG_EN), '#', LCD_CAPTURE_EN },
+   { TS(DT_TAG_D0), '(', LCD_CAPTURE_D0 << 0 },
+   { TS(DT_TAG_D1), ')', LCD_CAPTURE_D0 << 1 },
+   { TS(DT_TAG_D2), '*', LCD_CAPTURE_D0 << 2 },
+   { TS(DT_TAG_D3), '+', LCD_CAPTURE_D0 << 3 },
+   { TS(DT_TAG_D4), '$', LCD_CAPTURE_D0 << 4 },
+   { TS(DT_TAG_D5), '%', LCD_CAPTURE_D0 << 5 },
+   { TS(DT_TAG_D6), '&', LCD_CAPTURE_D0 << 6 },
+   { TS(DT_TAG_D7), '\'', LCD_CAPTURE_D0 << 7 }
+};
+
+/*-----------------------------------------------------------------------------
+ * @brief Returns the VCD-value of a signal: '0', '1', 'x' for unknown or
+ *        'z' for released data-pins.
+ */
+static char vcdValue( const LCD_CAPTURE_ITEM_T* pItem, unsigned int mask )
+{
+   if( (pItem->known & mask) != 0 )
+      return ((pItem->value & mask) != 0)? '1' : '0';
+   if( ((mask & LCD_CAPTURE_DATA) != 0) &&
+       ((pItem->value & pItem->known & LCD_CAPTURE_DATA_Z) != 0) )
+      return 'z';
+   return 'x';
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static void* vcdOnStart( struct seq_file* pSeqFile, loff_t* pPos )
+{
+   CAPTURE_COPY_T* pCopy = pSeqFile->private;
+
+   if( *pPos == 0 )
+      return SEQ_START_TOKEN;
+   if( *pPos > pCopy->count )
+      return NULL;
+   return &pCopy->aItem[*pPos - 1];
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static void* vcdOnNext( struct seq_file* pSeqFile, void* pValue, loff_t* pPos )
+{
+   (*pPos)++;
+   return vcdOnStart( pSeqFile, pPos );
+}
+
+/*-----------------------------------------------------------------------------
+ */
+static void vcdOnStop( struct seq_file* pSeqFile, void* pValue )
+{
+}
+
+/*-----------------------------------------------------------------------------
+ * @brief Prints the header of the VCD-file respectively the changed signals
+ *        of a captured item with its time relative to the first item.
+ */
+static int vcdOnShow( struct seq_file* pSeqFile, void* pValue )
 {
+   CAPTURE_COPY_T* pCopy = pSeqFile->private;
+   LCD_CAPTURE_ITEM_T* pItem = pValue;
+   LCD_CAPTURE_ITEM_T* pPrev;
    int i;
-   const IOC_INFO_T* pCurrentItem;
 
-   DEBUG_MESSAGE( "\n" );
-   seq_printf( pSeqFile, KBUILD_MODNAME " %dx%d Version: " __VERSION "\n\n",
-               global.oLcd.maxX, global.oLcd.maxY );
+   if( pValue == SEQ_START_TOKEN )
+   {
+      seq_puts( pSeqFile, "$version " KBUILD_MODNAME " " __VERSION " $end\n"
+                          "$timescale 1ns $end\n"
+                          "$scope module " KBUILD_MODNAME " $end\n" );
+      for( i = 0; i < ARRAY_SIZE( mg_vcdSignals ); i++ )
+         seq_printf( pSeqFile, "$var wire 1 %c %s $end\n",
+                     mg_vcdSignals[i].id, mg_vcdSignals[i].name );
+      seq_puts( pSeqFile, "$upscope $end\n$enddefinitions $end\n" );
+      return 0;
+   }
 
-   for( i = 0; i < ARRAY_SIZE( global.oLcd.port.list ); i++ )
+   pPrev = (pItem == pCopy->aItem)? NULL : (pItem - 1);
+   if( (pPrev == NULL) || (pItem->time != pPrev->time) )
+      seq_printf( pSeqFile, "#%llu\n", pItem->time - pCopy->aItem[0].time );
+   for( i = 0; i < ARRAY_SIZE( mg_vcdSignals ); i++ )
    {
-      seq_printf( pSeqFile, "GPIO %02d: %s = %s\n",
-                  global.oLcd.port.list[i]->number,
-                  global.oLcd.port.list[i]->name,
-                 (gpio_get_value( global.oLcd.port.list[i]->number ) != 0)?
-                 "high" : "low" );
+      if( (pPrev != NULL) &&
+          (vcdValue( pItem, mg_vcdSignals[i].mask ) ==
+           vcdValue( pPrev, mg_vcdSignals[i].mask )) )
+         continue;
+      seq_printf( pSeqFile, "%c%c\n", vcdValue( pItem, mg_vcdSignals[i].mask ),
+                  mg_vcdSignals[i].id );
    }
+   return 0;
+}
 
-   seq_printf( pSeqFile, "\nValid commands for ioctl():\n" ); 
+/*-----------------------------------------------------------------------------
+ */
+static const struct seq_operations mg_vcdSeqOps =
+{
+   .start = vcdOnStart,
+   .next  = vcdOnNext,
+   .stop  = vcdOnStop,
+   .show  = vcdOnShow
+};
 
-   for( pCurrentItem = mg_ioctlList; pCurrentItem->function != NULL; pCurrentItem++ )
+/*-----------------------------------------------------------------------------
+ * @brief Copies the ring-buffer without locking the writer.
+ *
+ * Items which could be overwritten by the writer while copying becomes
+ * discarded.
+ */
+static int vcdOnOpen( struct inode* pInode, struct file* pFile )
+{
+   LCD_CAPTURE_T* pCapture = &((LCD_OBJ_T*)pInode->i_private)->oCapture;
+   CAPTURE_COPY_T* pCopy;
+   unsigned int head, first, count, skip, i;
+   int ret;
+
+   head  = smp_load_acquire( &pCapture->head );
+   count = min( head, (unsigned int)CONFIG_AN_LCD_BUS_CAPTURE_SIZE );
+   first = head - count;
+
+   pCopy = vmalloc( sizeof( CAPTURE_COPY_T ) +
+                    count * sizeof( LCD_CAPTURE_ITEM_T ) );
+   if( pCopy == NULL )
+      return -ENOMEM;
+
+   for( i = 0; i < count; i++ )
+      pCopy->aItem[i] = pCapture->pRing[(first + i) &
+                                        (CONFIG_AN_LCD_BUS_CAPTURE_SIZE - 1)];
+   smp_rmb();
+   skip = READ_ONCE( pCapture->head ) - first;
+   skip = (skip > CONFIG_AN_LCD_BUS_CAPTURE_SIZE)?
+          min( skip - CONFIG_AN_LCD_BUS_CAPTURE_SIZE, count ) : 0;
+   pCopy->count = count - skip;
+   if( skip > 0 )
+      memmove( pCopy->aItem, &pCopy->aItem[skip],
+               pCopy->count * sizeof( LCD_CAPTURE_ITEM_T ) );
+
+   ret = seq_open( pFile, &mg_vcdSeqOps );
+   if( ret != 0 )
    {
-      seq_printf( pSeqFile, "%s:\t0x%08X\n",
-                  pCurrentItem->name,
-                  pCurrentItem->number );
+      vfree( pCopy );
+      return ret;
    }
-
-   seq_printf( pSeqFile, "\nAuto scroll: %s\n",
-               lcdIsAutoScroll()? "enabled" : "disabled" );
+   ((struct seq_file*)pFile->private_data)->private = pCopy;
    return 0;
 }
 
 /*-----------------------------------------------------------------------------
  */
-static int _procOnOpen( struct inode* pInode, struct file *pFile )
+static int vcdOnRelease( struct inode* pInode, struct file* pFile )
 {
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 0, 0)
-   return single_open( pFile, procOnOpen, NULL );
-#else
-   return single_open( pFile, procOnOpen, PDE_DATA( pInode ) );
-#endif
+   vfree( ((struct seq_file*)pFile->private_data)->private );
+   return seq_release( pInode, pFile );
 }
 
 /*-----------------------------------------------------------------------------
  */
-static ssize_t procOnWrite( struct file* seq, const char* pData,
-                            size_t len, loff_t* pPos )
+static const struct file_operations mg_debugFsVcdOps =
 {
-#ifdef CONFIG_DEBUG_AN_LCD
-   BYTE addrOut;
-#endif
+  .owner   = THIS_MODULE,
+  .open    = vcdOnOpen,
+  .read    = seq_read,
+  .llseek  = seq_lseek,
+  .release = vcdOnRelease
+};
 
-   DEBUG_MESSAGE( "\n" );
-   if( wait_event_interruptible( global.oWaitQueue.queue, !global.oWaitQueue.bussy ) )
-      return -ERESTARTSYS;
+/*-----------------------------------------------------------------------------
+ * @brief Reading of the capture-enable file: "0" or "1".
+ */
+static ssize_t debugFsOnReadCaptureEnable( struct file* pFile, char __user* pData,
+                                           size_t len, loff_t* pOffset )
+{
+   LCD_OBJ_T* pLcd = file_inode( pFile )->i_private;
+   char buffer[2] = { READ_ONCE( pLcd->oCapture.enabled )? '1' : '0', '\n' };
 
-   global.oWaitQueue.bussy = true;
-   if( *pData == '1' )
-      lcdInit();
+   return simple_read_from_buffer( pData, len, pOffset, buffer, sizeof( buffer ) );
+}
 
-#ifdef CONFIG_DEBUG_AN_LCD
-   /* IO-Test */
-   if( *pData == '2' ) 
-   {
-      for( addrOut = 0; addrOut <= 0x0F; addrOut++ )
-         lcdSetAddress( addrOut );
-   }
-#endif
-   global.oWaitQueue.bussy = false;
-   wake_up_interruptible( &global.oWaitQueue.queue );
+/*-----------------------------------------------------------------------------
+ * @brief Writing "1" in the capture-enable file starts the recording,
+ *        "0" stops it.
+ */
+static ssize_t debugFsOnWriteCaptureEnable( struct file* pFile,
+                                            const char __user* pData,
+                                            size_t len, loff_t* pOffset )
+{
+   LCD_OBJ_T* pLcd = file_inode( pFile )->i_private;
+   unsigned int enable;
+   int ret;
+
+   ret = kstrtouint_from_user( pData, len, 0, &enable );
+   if( ret != 0 )
+      return ret;
+   DEBUG_MESSAGE( ": " DEVICE_BASE_FILE_NAME "%d: %u\n", pLcd->minor, enable );
+   WRITE_ONCE( pLcd->oCapture.enabled, enable != 0 );
    return len;
 }
 
 /*-----------------------------------------------------------------------------
  */
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0)
-static const struct proc_ops global_procFileOps =
+static const struct file_operations mg_debugFsCaptureEnableOps =
 {
-  .proc_open    = _procOnOpen,
-  .proc_read    = seq_read,
-  .proc_write   = procOnWrite,
-  .proc_lseek   = seq_lseek,
-  .proc_release = single_release
+  .owner   = THIS_MODULE,
+  .read    = debugFsOnReadCaptureEnable,
+  .write   = debugFsOnWriteCaptureEnable
 };
+
+/*-----------------------------------------------------------------------------
+ * @brief Creates the sub-directory "capture" with the files "enable" and
+ *        "bus.vcd".
+ */
+static void debugFsCreateCapture( LCD_OBJ_T* pLcd )
+{
+   struct dentry* pDir;
+
+   pLcd->oCapture.pRing = vmalloc( CONFIG_AN_LCD_BUS_CAPTURE_SIZE *
+                                   sizeof( LCD_CAPTURE_ITEM_T ) );
+   if( pLcd->oCapture.pRing == NULL )
+   {
+      ERROR_MESSAGE( "Unable to alloc capture-buffer of %d items!\n",
+                     CONFIG_AN_LCD_BUS_CAPTURE_SIZE );
+      return;
+   }
+   pDir = debugfs_create_dir( "capture", pLcd->oLatency.pDir );
+   debugfs_create_file( "enable", S_IRUGO | S_IWUSR, pDir, pLcd,
+                        &mg_debugFsCaptureEnableOps );
+   debugfs_create_file( "bus.vcd", S_IRUGO, pDir, pLcd, &mg_debugFsVcdOps );
+}
+
 #else
-static const struct file_operations global_procFileOps =
+ #define debugFsCreateCapture( pLcd )
+#endif /* ifdef CONFIG_AN_LCD_BUS_CAPTURE */
+
+/*!----------------------------------------------------------------------------
+ * @brief Creates the directory of the display in the debug-file-system:
+ *
+ * anLcd<minor>/write/histogram  From write() till the data are on the display
+ * anLcd<minor>/ioctl/histogram  Execution time of each ioctl-command
+ * anLcd<minor>/bus/histogram    Each byte to the display-controller
+ * and in each sub-directory the file "reset".
+ * With CONFIG_AN_LCD_BUS_CAPTURE additionally:
+ * anLcd<minor>/capture/enable   Start and stop of the bus-capture
+ * anLcd<minor>/capture/bus.vcd  Captured bus-signals as value change dump
+ *
+ * @note Errors of the debug-file-system are not fatal for the driver.
+ */
+static void debugFsCreate( LCD_OBJ_T* pLcd )
 {
-  .owner   = THIS_MODULE,
-  .open    = _procOnOpen,
-  .read    = seq_read,
-  .write   = procOnWrite,
-  .llseek  = seq_lseek,
-  .release = single_release
-};
+   char name[16];
+   struct dentry* pDir;
+
+   spin_lock_init( &pLcd->oLatency.stampLock );
+   snprintf( name, sizeof( name ), DEVICE_BASE_FILE_NAME "%d", pLcd->minor );
+   pLcd->oLatency.pDir = debugfs_create_dir( name, global.pDebugFsDir );
+
+   pDir = debugfs_create_dir( "write", pLcd->oLatency.pDir );
+   debugfs_create_file( "histogram", S_IRUGO, pDir, pLcd,
+                        &mg_debugFsWriteHistogramOps );
+   debugfs_create_file( "reset", S_IWUSR, pDir, pLcd,
+                        &mg_debugFsWriteResetOps );
+
+   pDir = debugfs_create_dir( "ioctl", pLcd->oLatency.pDir );
+   debugfs_create_file( "histogram", S_IRUGO, pDir, pLcd,
+                        &mg_debugFsIoctlHistogramOps );
+   debugfs_create_file( "reset", S_IWUSR, pDir, pLcd,
+                        &mg_debugFsIoctlResetOps );
+
+   pDir = debugfs_create_dir( "bus", pLcd->oLatency.pDir );
+   debugfs_create_file( "histogram", S_IRUGO, pDir, pLcd,
+                        &mg_debugFsBusHistogramOps );
+   debugfs_create_file( "reset", S_IWUSR, pDir, pLcd,
+                        &mg_debugFsBusResetOps );
+
+   debugFsCreateCapture( pLcd );
+}
+
+/*-----------------------------------------------------------------------------
+ * @note Becomes invoked after the last bus-access only.
+ */
+static inline void debugFsRemove( LCD_OBJ_T* pLcd )
+{
+   debugfs_remove_recursive( pLcd->oLatency.pDir );
+#ifdef CONFIG_AN_LCD_BUS_CAPTURE
+   pLcd->oCapture.enabled = false;
+   vfree( pLcd->oCapture.pRing );
 #endif
+}
 
-#endif /* ifdef CONFIG_PROC_FS */
-/* Process-file-system end ***************************************************/
+#else /* ifdef CONFIG_DEBUG_FS */
+
+static inline void debugFsCreate( LCD_OBJ_T* pLcd ) {}
+static inline void debugFsRemove( LCD_OBJ_T* pLcd ) {}
+
+#endif /* else ifdef CONFIG_DEBUG_FS */
+/* Debug-file-system end *****************************************************/
 
 /* Power management functions begin ******************************************/
 #ifdef CONFIG_PM_
@@ -698,10 +2558,27 @@ static int onPmResume( struct device* pDev )
 
 
 #ifndef __NO_DEV_TREE
+/*!----------------------------------------------------------------------------
+ * @brief Returns true if pNumber points to the GPIO-number of one of the
+ *        data-pins D0 till D3, which are used in 8-bit mode only.
+ */
+static bool isLowDataPin( LCD_OBJ_T* pLcd, int* pNumber )
+{
+   int i;
+
+   for( i = ARRAY_SIZE( pLcd->port.data ) - LCD_LOW_DATA_PINS;
+        i < ARRAY_SIZE( pLcd->port.data ); i++ )
+   {
+      if( pNumber == &pLcd->port.data[i].pin.number )
+         return true;
+   }
+   return false;
+}
+
 /*!----------------------------------------------------------------------------
  * 
  */
-static int __init readDviceTreeNode( void )
+static int readDviceTreeNode( LCD_OBJ_T* pLcd, struct device_node* pNode )
 {
    typedef struct
    {
@@ -709,39 +2586,55 @@ static int __init readDviceTreeNode( void )
       const char* name;
    } LIST;
 
-   LIST list[ARRAY_SIZE( global.oLcd.port.list ) + 2];
-   struct device_node* pNode;
+   LIST list[ARRAY_SIZE( pLcd->port.list ) + 2];
    const void* pProperty;
+   const char* pName;
+   const LCD_TIMING_T* pTiming;
    int i;
    int len;
+   int missingLowData = 0;
    int ret = 0;
 
-   pNode = of_find_node_by_name( NULL, DEVICE_BASE_FILE_NAME );
    if( pNode == NULL )
    {
       ERROR_MESSAGE( ": Devicenode " DEVICE_BASE_FILE_NAME " not found!\n" );
       return -1;
    }
 
-   for( i = 0; i < ARRAY_SIZE( global.oLcd.port.list ); i++ )
+   for( i = 0; i < ARRAY_SIZE( pLcd->port.list ); i++ )
    {
-      list[i].pNumber = &global.oLcd.port.list[i]->number;
-      list[i].name    = global.oLcd.port.list[i]->name;
+      list[i].pNumber = &pLcd->port.list[i]->number;
+      list[i].name    = pLcd->port.list[i]->name;
    }
-   list[i].pNumber = &global.oLcd.maxX;
+   list[i].pNumber = &pLcd->maxX;
    list[i].name    = TS(DT_TAG_X);
    i++;
-   list[i].pNumber = &global.oLcd.maxY;
+   list[i].pNumber = &pLcd->maxY;
    list[i].name    = TS(DT_TAG_Y);
 
    for( i = 0; i < ARRAY_SIZE( list ); i++ )
    {
       pProperty = of_get_property( pNode, list[i].name, &len );
-      if( pProperty == NULL )
-      {
-         ERROR_MESSAGE( ": Could not found property \"%s\" of "
-                        DEVICE_BASE_FILE_NAME,
+      if( (pProperty == NULL) &&
+          (list[i].pNumber == &pLcd->port.rw.number) )
+      { /*
+         * Without property "rw" the pin r/w of the display is assumed to be
+         * tied to ground, so the display becomes operated in write-only mode.
+         */
+         DEBUG_MESSAGE( ": Property \"%s\" not found, write-only mode\n",
                         list[i].name );
+         pLcd->writeOnly = true;
+      }
+      else if( (pProperty == NULL) && isLowDataPin( pLcd, list[i].pNumber ) )
+      { /*
+         * The properties "d0" till "d3" are necessary for the 8-bit mode only.
+         */
+         missingLowData++;
+      }
+      else if( pProperty == NULL )
+      {
+         ERROR_MESSAGE( ": Could not found property \"%s\" of %s\n",
+                        list[i].name, pNode->name );
          ret = -1;
       }
       else
@@ -753,97 +2646,567 @@ static int __init readDviceTreeNode( void )
       }
    }
 
+   if( missingLowData == 0 )
+      pLcd->port.dataCount = ARRAY_SIZE( pLcd->port.data );
+   else if( missingLowData != LCD_LOW_DATA_PINS )
+   {
+      ERROR_MESSAGE( ": Properties \"" TS(DT_TAG_D0) "\" till \"" TS(DT_TAG_D3)
+                     "\" are incomplete for 8-bit mode\n" );
+      ret = -1;
+   }
+   DEBUG_MESSAGE( ": %u-bit data-bus\n", pLcd->port.dataCount );
+
+   pLcd->pushPull |= of_property_read_bool( pNode, TS(DT_TAG_PUSH_PULL) );
+
+   /*
+    * Without property "clk-delay-ns" the CLK-delay becomes calibrated.
+    */
+   if( of_property_read_u32( pNode, TS(DT_TAG_CLK_DELAY), &pLcd->clkDelayNs ) == 0 )
+   {
+      if( pLcd->clkDelayNs > LCD_MAX_CLK_DELAY_NS )
+      {
+         ERROR_MESSAGE( ": Property \"" TS(DT_TAG_CLK_DELAY) "\" %u out of "
+                        "range of %u\n", pLcd->clkDelayNs, LCD_MAX_CLK_DELAY_NS );
+         pLcd->clkDelayNs = LCD_MAX_CLK_DELAY_NS;
+         ret = -1;
+      }
+      else
+         pLcd->clkSource = CLK_DEVICE_TREE;
+   }
+
+   /*
+    * Without property "controller" the default-profile remains.
+    */
+   if( of_property_read_string( pNode, TS(DT_TAG_CONTROLLER), &pName ) == 0 )
+   {
+      pTiming = findTiming( pName );
+      if( pTiming != NULL )
+      {
+         pLcd->pTiming = pTiming;
+         DEBUG_MESSAGE( ": Property: \"" TS(DT_TAG_CONTROLLER) "\", value: %s\n",
+                        pName );
+      }
+      else
+      {
+         ERROR_MESSAGE( ": Unknown controller \"%s\" in property \""
+                        TS(DT_TAG_CONTROLLER) "\"\n", pName );
+         ret = -1;
+      }
+   }
    return ret;
 }
 #endif /* ifndef __NO_DEV_TREE */
 
 /*!----------------------------------------------------------------------------
  */
-static void releasePort( void )
+static void releasePort( LCD_OBJ_T* pLcd )
 {
    int i;
-   for( i = 0; i < ARRAY_SIZE( global.oLcd.port.list ); i++ )
+   for( i = 0; i < ARRAY_SIZE( pLcd->port.list ); i++ )
    {
-      if( global.oLcd.port.list[i]->initialized )
+      if( pLcd->port.list[i]->initialized )
       {
-         global.oLcd.port.list[i]->initialized = FALSE;
-         gpio_free( global.oLcd.port.list[i]->number );
+         pLcd->port.list[i]->initialized = FALSE;
+         gpio_free( pLcd->port.list[i]->number );
          DEBUG_MESSAGE( ": free GPIO-number %02d name: %s\n",
-                        global.oLcd.port.list[i]->number,
-                        global.oLcd.port.list[i]->name );
+                        pLcd->port.list[i]->number,
+                        pLcd->port.list[i]->name );
       }
    }
 }
 
+/*!----------------------------------------------------------------------------
+ * @brief Requests a pin with its kind of driving and its start-level.
+ *
+ * Open-drain becomes requested together with the pin, so gpiolib keeps it
+ * for each later change of the direction. A gpio-chip supporting it drives
+ * the pins by values only, otherwise the open-drain becomes imitated by
+ * switching the direction of the pin.
+ */
+static int requestPin( LCD_OBJ_T* pLcd, LCD_GPIO_PIN_T* pPin )
+{
+   int ret;
+   int value = (pPin->init != OUTPUT_LOW);
+
+   if( pLcd->pushPull )
+   {
+      pPin->drive = PUSH_PULL;
+      return gpio_request_one( pPin->number,
+                               (pPin->init == INPUT)? GPIOF_IN :
+                               value? GPIOF_OUT_INIT_HIGH : GPIOF_OUT_INIT_LOW,
+                               pPin->name );
+   }
+
+#ifdef GPIOF_OPEN_DRAIN
+   /*
+    * A gpio-chip without open-drain gets the high-level by releasing
+    * the pin already by gpiolib.
+    */
+   ret = gpio_request_one( pPin->number, GPIOF_OPEN_DRAIN |
+                           (value? GPIOF_OUT_INIT_HIGH : GPIOF_OUT_INIT_LOW),
+                           pPin->name );
+   if( ret != 0 )
+      return ret;
+   /*
+    * Repeating the configuration of the request tells whether the
+    * gpio-chip supports open-drain by itself.
+    */
+   if( gpiod_set_config( gpio_to_desc( pPin->number ),
+            pinconf_to_config_packed( PIN_CONFIG_DRIVE_OPEN_DRAIN, 0 ) ) == 0 )
+   {
+      pPin->drive = OPEN_DRAIN;
+      return 0;
+   }
+#else
+   /*
+    * Without the request-flag gpiolib would reset an open-drain configured
+    * afterwards to push-pull at the next gpiod_direction_output(), so it
+    * remains imitated.
+    */
+   ret = gpio_request_one( pPin->number,
+                           value? GPIOF_IN : GPIOF_OUT_INIT_LOW, pPin->name );
+   if( ret != 0 )
+      return ret;
+#endif
+   pPin->drive = OPEN_DRAIN_EMULATED;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Returns false for the pin r/w in write-only mode and for the
+ *        data-pins D0 till D3 in 4-bit mode.
+ */
+static bool isPinUsed( LCD_OBJ_T* pLcd, LCD_GPIO_PIN_T* pPin )
+{
+   int i;
+
+   if( pLcd->writeOnly && (pPin == &pLcd->port.rw) )
+      return false;
+   for( i = pLcd->port.dataCount; i < ARRAY_SIZE( pLcd->port.data ); i++ )
+   {
+      if( pPin == &pLcd->port.data[i].pin )
+         return false;
+   }
+   return true;
+}
+
 /*!----------------------------------------------------------------------------
  * 
  */
-static int __init requestPort( void )
+static int requestPort( LCD_OBJ_T* pLcd )
 {
    int i, ret;
-   for( i = 0; i < ARRAY_SIZE( global.oLcd.port.list ); i++ )
+   for( i = 0; i < ARRAY_SIZE( pLcd->port.list ); i++ )
    {
-      if( global.oLcd.port.list[i]->initialized )
+      if( pLcd->port.list[i]->initialized )
+         continue;
+      if( !isPinUsed( pLcd, pLcd->port.list[i] ) )
          continue;
-      ret = gpio_request( global.oLcd.port.list[i]->number,
-                          global.oLcd.port.list[i]->name );
+      ret = requestPin( pLcd, pLcd->port.list[i] );
       if( ret != 0 )
       {
          ERROR_MESSAGE( ": %d: Unable to request GPIO-number %02d name: %s\n",
                         ret,
-                        global.oLcd.port.list[i]->number,
-                        global.oLcd.port.list[i]->name );
-         releasePort();
-         return ret;
-      }
-      global.oLcd.port.list[i]->initialized = TRUE;
-      if( global.oLcd.port.list[i]->init == INPUT )
-         ret = gpio_direction_input( global.oLcd.port.list[i]->number );
-      else
-         ret = gpio_direction_output( global.oLcd.port.list[i]->number,
-                                      (global.oLcd.port.list[i]->init == OUTPUT_LOW)? 0 : 1 );
-      if( ret != 0 )
-      {
-         ERROR_MESSAGE( ": %d: Unable to set direction of GPIO-number %02d name: %s\n",
-                         ret,
-                         global.oLcd.port.list[i]->number,
-                         global.oLcd.port.list[i]->name );
-         releasePort();
+                        pLcd->port.list[i]->number,
+                        pLcd->port.list[i]->name );
+         releasePort( pLcd );
          return ret;
       }
-      DEBUG_MESSAGE( ": GPIO-number %02d name: %s initialized\n",
-                     global.oLcd.port.list[i]->number,
-                     global.oLcd.port.list[i]->name );
+      pLcd->port.list[i]->initialized = TRUE;
+      pLcd->port.list[i]->pDesc =
+                              gpio_to_desc( pLcd->port.list[i]->number );
+      DEBUG_MESSAGE( ": GPIO-number %02d name: %s initialized as %s\n",
+                     pLcd->port.list[i]->number,
+                     pLcd->port.list[i]->name,
+                     getDriveStr( pLcd->port.list[i]->drive ) );
+   }
+   pLcd->port.dataDrive = pLcd->pushPull? PUSH_PULL : OPEN_DRAIN;
+   pLcd->port.dataMask = 0;
+   for( i = 0; i < pLcd->port.dataCount; i++ )
+   {
+      pLcd->port.dataDesc[i] = pLcd->port.data[i].pin.pDesc;
+      pLcd->port.dataMask |= pLcd->port.data[i].mask;
+      if( pLcd->port.data[i].pin.drive == OPEN_DRAIN_EMULATED )
+         pLcd->port.dataDrive = OPEN_DRAIN_EMULATED;
    }
+   pLcd->port.dataIsOutput = false;
    return 0;
 }
 
+/* Sysfs begin ***************************************************************/
 /*!----------------------------------------------------------------------------
- * @brief Driver constructor
+ * @brief Shows the CLK-delay in /sys/class/anLcd/anLcd<minor>/clkDelayNs.
  */
-static int __init driverInit( void )
+static ssize_t onSysfsShowClkDelay( struct device* pDevice,
+                                    struct device_attribute* pAttr,
+                                    char* pBuffer )
 {
-   DEBUG_MESSAGE( "*** Loading driver \"" DEVICE_BASE_FILE_NAME "\" ***\n" );
+   LCD_OBJ_T* pLcd = dev_get_drvdata( pDevice );
+
+   return sprintf( pBuffer, "%u\n", READ_ONCE( pLcd->clkDelayNs ) );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Overwrites the calibrated CLK-delay, e.g.:
+ *        echo 2000 > /sys/class/anLcd/anLcd0/clkDelayNs
+ */
+static ssize_t onSysfsStoreClkDelay( struct device* pDevice,
+                                     struct device_attribute* pAttr,
+                                     const char* pBuffer, size_t len )
+{
+   LCD_OBJ_T* pLcd = dev_get_drvdata( pDevice );
+   unsigned int ns;
+   int ret;
+
+   ret = kstrtouint( pBuffer, 0, &ns );
+   if( ret != 0 )
+      return ret;
+   if( ns > LCD_MAX_CLK_DELAY_NS )
+      return -EINVAL;
+
+   /*
+    * The delay must not change during a bus-transfer.
+    */
+   ret = lockBus( pLcd, true );
+   if( ret != 0 )
+      return ret;
+   WRITE_ONCE( pLcd->clkDelayNs, ns );
+   WRITE_ONCE( pLcd->clkSource, CLK_SYSFS );
+   unlockBus( pLcd );
+   return len;
+}
+
+static DEVICE_ATTR( clkDelayNs, S_IRUGO | S_IWUSR,
+                    onSysfsShowClkDelay, onSysfsStoreClkDelay );
+
+static struct attribute* mg_apSysfsAttributes[] =
+{
+   &dev_attr_clkDelayNs.attr,
+   NULL
+};
+
+static const struct attribute_group mg_sysfsGroup =
+{
+   .attrs = mg_apSysfsAttributes
+};
+
+static const struct attribute_group* mg_apSysfsGroups[] =
+{
+   &mg_sysfsGroup,
+   NULL
+};
+/* Sysfs end *****************************************************************/
+
+/* Display object begin ******************************************************/
+/*!----------------------------------------------------------------------------
+ * @brief Allocates a display-object initialized by the default settings.
+ */
+LCD_OBJ_T* allocLcdObject( void )
+{
+   LCD_OBJ_T* pLcd;
+   int i;
 
-   if( alloc_chrdev_region( &global.deviceNumber, 0, 1, DEVICE_BASE_FILE_NAME ) < 0 )
+   pLcd = kmalloc( sizeof( LCD_OBJ_T ), GFP_KERNEL );
+   if( pLcd == NULL )
    {
-      ERROR_MESSAGE( "alloc_chrdev_region\n" );
-      return -EIO;
+      ERROR_MESSAGE( "Unable to alloc display-object!\n" );
+      return NULL;
+   }
+   *pLcd = mg_defaultLcd;
+   if( kfifo_alloc( &pLcd->oFifo, mg_fifoSize, GFP_KERNEL ) != 0 )
+   {
+      ERROR_MESSAGE( "Unable to alloc write-FIFO of %u bytes!\n",
+                     mg_fifoSize );
+      kfree( pLcd );
+      return NULL;
+   }
+   pLcd->port.list[0] = &pLcd->port.rs;
+   pLcd->port.list[1] = &pLcd->port.rw;
+   pLcd->port.list[2] = &pLcd->port.en;
+   for( i = 0; i < ARRAY_SIZE( pLcd->port.data ); i++ )
+      pLcd->port.list[3 + i] = &pLcd->port.data[i].pin;
+   atomic_set( &pLcd->openCount, 0 );
+   atomic_set( &pLcd->flushCount, 0 );
+   kref_init( &pLcd->oRef );
+   return pLcd;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static void onLcdObjectRelease( struct kref* pRef )
+{
+   LCD_OBJ_T* pLcd = container_of( pRef, LCD_OBJ_T, oRef );
+
+   kfifo_free( &pLcd->oFifo );
+   kfree( pLcd );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Drops a reference of the display-object, the last one frees it.
+ *
+ * The device-driver drops its reference after unregisterLcdObject() resp.
+ * when the probe fails, each opened device-file in onClose().
+ */
+void putLcdObject( LCD_OBJ_T* pLcd )
+{
+   kref_put( &pLcd->oRef, onLcdObjectRelease );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Creates the device-file of a display whose port is ready and
+ *        starts its initialization.
+ *
+ * Common part of the probe-functions of the platform- and I2C-driver.
+ */
+int registerLcdObject( LCD_OBJ_T* pLcd, struct device* pParent )
+{
+   dev_t deviceNumber;
+   int minor;
+   int ret;
+
+   /*
+    * The minor number becomes reserved only, the proc-file and onOpen()
+    * find the object not till it's completely initialized.
+    */
+   mutex_lock( &global.oInstanceMutex );
+   for( minor = 0; minor < ARRAY_SIZE( global.aMinorReserved ); minor++ )
+   {
+      if( !global.aMinorReserved[minor] )
+         break;
+   }
+   if( minor < ARRAY_SIZE( global.aMinorReserved ) )
+      global.aMinorReserved[minor] = true;
+   mutex_unlock( &global.oInstanceMutex );
+   if( minor == ARRAY_SIZE( global.aMinorReserved ) )
+   {
+      ERROR_MESSAGE( "More than %d displays are not supported!\n",
+                     CONFIG_AN_LCD_MAX_DEVICES );
+      return -ENOSPC;
    }
+   pLcd->minor = minor;
 
-   global.pObject = cdev_alloc();
-   if( global.pObject == NULL )
+   init_waitqueue_head( &pLcd->oWaitQueue.queue );
+   INIT_WORK( &pLcd->oWorkQueue.oInit, onWorkqueueInit );
+   INIT_DELAYED_WORK( &pLcd->oWorkQueue.oWrite, onWorkqueueWrite );
+   pLcd->refreshMs = min( mg_refreshMs, (unsigned int)LCD_MAX_REFRESH_MS );
+   lcdResetScreen( pLcd );
+
+   mutex_init( &pLcd->oWriteMutex );
+   mutex_init( &pLcd->oBusMutex );
+   mutex_init( &pLcd->oStateMutex );
+
+   deviceNumber = MKDEV( MAJOR( global.deviceNumber ), minor );
+   pLcd->pCdev = cdev_alloc();
+   if( pLcd->pCdev == NULL )
    {
       ERROR_MESSAGE( "cdev_alloc\n" );
-      goto L_DEVICE_NUMBER;
+      ret = -ENOMEM;
+      goto L_MINOR_RELEASE;
    }
-
-   global.pObject->owner = THIS_MODULE;
-   global.pObject->ops = &global_fops;
-   if( cdev_add( global.pObject, global.deviceNumber, 1 ) )
+   pLcd->pCdev->ops   = &global_fops;
+   pLcd->pCdev->owner = THIS_MODULE;
+   ret = cdev_add( pLcd->pCdev, deviceNumber, 1 );
+   if( ret != 0 )
    {
       ERROR_MESSAGE( "cdev_add\n" );
-      goto L_REMOVE_DEV;
+      kobject_put( &pLcd->pCdev->kobj );
+      goto L_MINOR_RELEASE;
+   }
+
+   pLcd->pDevice = device_create_with_groups( global.pClass,
+                                              pParent,
+                                              deviceNumber,
+                                              pLcd,
+                                              mg_apSysfsGroups,
+                                              DEVICE_BASE_FILE_NAME "%d",
+                                              minor );
+   if( IS_ERR( pLcd->pDevice ) )
+   {
+      ERROR_MESSAGE( "device_create: " DEVICE_BASE_FILE_NAME "%d\n", minor );
+      ret = PTR_ERR( pLcd->pDevice );
+      goto L_CDEV_REMOVE;
+   }
+
+   debugFsCreate( pLcd );
+
+   mutex_lock( &global.oInstanceMutex );
+   global.apLcd[minor] = pLcd;
+   mutex_unlock( &global.oInstanceMutex );
+
+   queue_work( global.poWorkqueue, &pLcd->oWorkQueue.oInit );
+
+   DEBUG_MESSAGE( ": Instance " DEVICE_BASE_FILE_NAME "%d created\n", minor );
+   return 0;
+
+L_CDEV_REMOVE:
+   cdev_del( pLcd->pCdev );
+L_MINOR_RELEASE:
+   mutex_lock( &global.oInstanceMutex );
+   global.aMinorReserved[minor] = false;
+   mutex_unlock( &global.oInstanceMutex );
+   return ret;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Switches the display off and removes its device-file, the port
+ *        and the object remains.
+ *
+ * Device-files still opened keep the object by their reference, but
+ * they can't access the display anymore, so the caller can release
+ * the port afterwards and drop its reference by putLcdObject().
+ */
+void unregisterLcdObject( LCD_OBJ_T* pLcd )
+{
+   device_destroy( global.pClass, pLcd->pCdev->dev );
+   cdev_del( pLcd->pCdev );
+
+   flush_work( &pLcd->oWorkQueue.oInit );
+   flush_delayed_work( &pLcd->oWorkQueue.oWrite );
+
+   /*
+    * From now on lockBus() fails and writers don't queue the write-work
+    * anymore, unlockBus() wakes up the waiting tasks.
+    */
+   mutex_lock( &pLcd->oWriteMutex );
+   mutex_lock( &pLcd->oBusMutex );
+   WRITE_ONCE( pLcd->isRemoved, true );
+   lockState( pLcd );
+   lcdOff( pLcd );
+   unlockState( pLcd );
+   flushDisplay( pLcd );
+   unlockBus( pLcd );
+   mutex_unlock( &pLcd->oWriteMutex );
+
+   cancel_work_sync( &pLcd->oWorkQueue.oInit );
+   cancel_delayed_work_sync( &pLcd->oWorkQueue.oWrite );
+   debugFsRemove( pLcd );
+
+   mutex_lock( &global.oInstanceMutex );
+   global.apLcd[pLcd->minor] = NULL;
+   global.aMinorReserved[pLcd->minor] = false;
+   mutex_unlock( &global.oInstanceMutex );
+}
+/* Display object end ********************************************************/
+
+/* Platform driver begin *****************************************************/
+/*!----------------------------------------------------------------------------
+ * @brief Creates the object, the device-file and the GPIOs for a display.
+ *
+ * Becomes invoked for each display-node in the device-tree with a matching
+ * property "compatible", respectively once by the platform-device
+ * registered in driverInit() when no device-tree is used.
+ */
+static int onProbe( struct platform_device* pPlatformDev )
+{
+   LCD_OBJ_T* pLcd;
+   int ret;
+
+   DEBUG_MESSAGE( ": %s\n", dev_name( &pPlatformDev->dev ) );
+
+   pLcd = allocLcdObject();
+   if( pLcd == NULL )
+      return -ENOMEM;
+
+#ifndef __NO_DEV_TREE
+   if( readDviceTreeNode( pLcd, pPlatformDev->dev.of_node ) != 0 )
+   {
+      ret = -EINVAL;
+      goto L_OBJECT_FREE;
+   }
+#endif
+
+   ret = requestPort( pLcd );
+   if( ret != 0 )
+      goto L_OBJECT_FREE;
+
+   platform_set_drvdata( pPlatformDev, pLcd );
+   ret = registerLcdObject( pLcd, &pPlatformDev->dev );
+   if( ret != 0 )
+      goto L_PORT_RELEASE;
+
+   return 0;
+
+L_PORT_RELEASE:
+   releasePort( pLcd );
+L_OBJECT_FREE:
+   putLcdObject( pLcd );
+   return ret;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Switches the display off and removes its object and device-file.
+ */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0)
+static void onRemove( struct platform_device* pPlatformDev )
+#else
+static int onRemove( struct platform_device* pPlatformDev )
+#endif
+{
+   LCD_OBJ_T* pLcd = platform_get_drvdata( pPlatformDev );
+
+   DEBUG_MESSAGE( ": " DEVICE_BASE_FILE_NAME "%d\n", pLcd->minor );
+
+   unregisterLcdObject( pLcd );
+   releasePort( pLcd );
+
+   putLcdObject( pLcd );
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 11, 0)
+   return 0;
+#endif
+}
+
+#ifndef __NO_DEV_TREE
+/*!----------------------------------------------------------------------------
+ */
+static const struct of_device_id mg_ofMatchTable[] =
+{
+   { .compatible = DEVICE_BASE_FILE_NAME },
+   { }
+};
+MODULE_DEVICE_TABLE( of, mg_ofMatchTable );
+#endif
+
+/*!----------------------------------------------------------------------------
+ */
+static struct platform_driver mg_platformDriver =
+{
+   .probe  = onProbe,
+   .remove = onRemove,
+   .driver =
+   {
+      .name = DEVICE_BASE_FILE_NAME,
+   #ifndef __NO_DEV_TREE
+      .of_match_table = mg_ofMatchTable,
+   #endif
+   }
+};
+/* Platform driver end *******************************************************/
+
+/*!----------------------------------------------------------------------------
+ * @brief Driver constructor
+ */
+static int __init driverInit( void )
+{
+   DEBUG_MESSAGE( "*** Loading driver \"" DEVICE_BASE_FILE_NAME "\" ***\n" );
+
+   /*
+    * kfifo_alloc() would round up a size which isn't a power of two
+    * silently resp. fail with a misleading "out of memory" at zero.
+    */
+   if( !is_power_of_2( mg_fifoSize ) )
+   {
+      ERROR_MESSAGE( "fifoSize=%u has to be a power of two!\n", mg_fifoSize );
+      return -EINVAL;
+   }
+
+   mutex_init( &global.oInstanceMutex );
+
+   if( alloc_chrdev_region( &global.deviceNumber, 0,
+                            ARRAY_SIZE( global.apLcd ),
+                            DEVICE_BASE_FILE_NAME ) < 0 )
+   {
+      ERROR_MESSAGE( "alloc_chrdev_region\n" );
+      return -EIO;
    }
 
   /*!
@@ -857,22 +3220,8 @@ static int __init driverInit( void )
    if( IS_ERR(global.pClass) )
    {
       ERROR_MESSAGE( "class_create: No udev support\n" );
-      goto L_CLASS_REMOVE;
-   }
-
-   if( device_create( global.pClass,
-                      NULL,
-                      global.deviceNumber,
-                      NULL,
-                      DEVICE_BASE_FILE_NAME )
-      == NULL )
-   {
-      ERROR_MESSAGE( "device_create: " DEVICE_BASE_FILE_NAME "\n" );
-      goto L_INSTANCE_REMOVE;
+      goto L_DEVICE_NUMBER;
    }
-   global.oLcd.minor = 0;
-   atomic_set( &global.oLcd.openCount, 0 );
-   DEBUG_MESSAGE( ": Instance " DEVICE_BASE_FILE_NAME " created\n" );
 
 #ifdef CONFIG_PM_
   global.pClass->suspend = onPmSuspend;
@@ -895,7 +3244,6 @@ static int __init driverInit( void )
    if( global.poProcFile == NULL )
    {
       ERROR_MESSAGE( "Unable to create proc entry: /proc/" PROC_FS_NAME " !\n" );
-      //goto L_INSTANCE_REMOVE;
       /*
        * For the case there is an old entry in the proc-filesystem it`s better
        * to jump to remove_proc_entry().
@@ -904,77 +3252,91 @@ static int __init driverInit( void )
    }
 #endif
 
-   global.oWorkQueue.poWorkqueue = create_workqueue( KBUILD_MODNAME );
-   if( global.oWorkQueue.poWorkqueue == NULL )
+  /*
+   * Unbound, so the work-items of different displays can run concurrently.
+   */
+   global.poWorkqueue = alloc_workqueue( KBUILD_MODNAME, WQ_UNBOUND, 0 );
+   if( global.poWorkqueue == NULL )
    {
       ERROR_MESSAGE( "Unable to create work-queue!\n" );
     #ifdef CONFIG_PROC_FS
       goto L_PROC_ENTRY_REMOVE;
     #else
-      goto L_INSTANCE_REMOVE;
+      goto L_CLASS_REMOVE;
     #endif
    }
 
-   INIT_WORK( &global.oWorkQueue.oInit, onWorkqueueInit );
-   INIT_WORK( &global.oWorkQueue.oWrite, onWorkqueueWrite );
-
-   global.oLcd.port.list[0] = &global.oLcd.port.rs;
-   global.oLcd.port.list[1] = &global.oLcd.port.rw;
-   global.oLcd.port.list[2] = &global.oLcd.port.en;
-   global.oLcd.port.list[3] = &global.oLcd.port.data[0].pin;
-   global.oLcd.port.list[4] = &global.oLcd.port.data[1].pin;
-   global.oLcd.port.list[5] = &global.oLcd.port.data[2].pin;
-   global.oLcd.port.list[6] = &global.oLcd.port.data[3].pin;
-#ifndef __NO_DEV_TREE
-   if( readDviceTreeNode() != 0 )
-      goto L_WORKQUEUE_REMOVE;
+#ifdef CONFIG_DEBUG_FS
+   global.pDebugFsDir = debugfs_create_dir( DEVICE_BASE_FILE_NAME, NULL );
 #endif
-   if( requestPort() != 0 )
+
+   if( platform_driver_register( &mg_platformDriver ) != 0 )
+   {
+      ERROR_MESSAGE( "platform_driver_register\n" );
       goto L_WORKQUEUE_REMOVE;
+   }
 
-   init_waitqueue_head( &global.oWaitQueue.queue );
+#ifdef __NO_DEV_TREE
+   global.pPlatformDevice = platform_device_register_simple( DEVICE_BASE_FILE_NAME,
+                                                             -1, NULL, 0 );
+   if( IS_ERR( global.pPlatformDevice ) )
+   {
+      ERROR_MESSAGE( "platform_device_register_simple\n" );
+      goto L_DRIVER_REMOVE;
+   }
+#endif
 
-   global.oBuffer.len = 0;
-   global.oBuffer.capacity = global.oLcd.maxX * global.oLcd.maxY * 2;
-   global.oBuffer.pData = kmalloc( global.oBuffer.capacity, GFP_KERNEL );
-   if( global.oBuffer.pData == NULL )
+  /*
+   * Displays on a PCF8574 I2C-backpack.
+   */
+   if( pcf8574DriverRegister() != 0 )
    {
-      ERROR_MESSAGE( "Unable to alloc kernel-memory of %d bytes!\n",
-                     global.oBuffer.capacity );
-      goto L_WORKQUEUE_REMOVE;
+      ERROR_MESSAGE( "i2c_add_driver\n" );
+      goto L_DEVICE_REMOVE;
    }
 
-   global.oWaitQueue.bussy = true;
-   queue_work( global.oWorkQueue.poWorkqueue, &global.oWorkQueue.oInit );
+  /*
+   * Displays emulated in memory.
+   */
+   if( emulatorCreate() != 0 )
+   {
+      ERROR_MESSAGE( "emulatorCreate\n" );
+      goto L_I2C_DRIVER_REMOVE;
+   }
 
    DEBUG_MESSAGE( "success\n" );
    return 0;
 
+L_I2C_DRIVER_REMOVE:
+   pcf8574DriverUnregister();
+L_DEVICE_REMOVE:
+#ifdef __NO_DEV_TREE
+   platform_device_unregister( global.pPlatformDevice );
+L_DRIVER_REMOVE:
+#endif
+   DEBUG_MESSAGE( "platform_driver_unregister()\n" );
+   platform_driver_unregister( &mg_platformDriver );
+
 L_WORKQUEUE_REMOVE:
+#ifdef CONFIG_DEBUG_FS
+   debugfs_remove_recursive( global.pDebugFsDir );
+#endif
    DEBUG_MESSAGE( "destroy_workqueue()\n" );
-   destroy_workqueue( global.oWorkQueue.poWorkqueue );
+   destroy_workqueue( global.poWorkqueue );
 
 #ifdef CONFIG_PROC_FS
 L_PROC_ENTRY_REMOVE:
    DEBUG_MESSAGE( "remove_proc_entry()\n" );
    remove_proc_entry( PROC_FS_NAME, NULL );
-#endif
-
-L_INSTANCE_REMOVE:
-   DEBUG_MESSAGE( "device_destroy()\n" );
-   device_destroy( global.pClass, global.deviceNumber );
-
+#else
 L_CLASS_REMOVE:
+#endif
    DEBUG_MESSAGE( "class_destroy()\n" );
    class_destroy( global.pClass );
 
-L_REMOVE_DEV:
-   DEBUG_MESSAGE( "kobject_put()\n" );
-   kobject_put( &global.pObject->kobj );
-
 L_DEVICE_NUMBER:
    DEBUG_MESSAGE( "unregister_chrdev_region()\n" );
-   unregister_chrdev_region( global.deviceNumber, 1 );
+   unregister_chrdev_region( global.deviceNumber, ARRAY_SIZE( global.apLcd ) );
 
    DEBUG_MESSAGE( "Failed to load driver \"" DEVICE_BASE_FILE_NAME "\"\n" );
    return -EIO;
@@ -987,22 +3349,24 @@ static void __exit driverExit( void )
 {
    DEBUG_MESSAGE( "*** Removing driver \"" DEVICE_BASE_FILE_NAME "\" ***\n" );
 
-  //cancel_work( &global.oWorkQueue.oInit );
-   destroy_workqueue( global.oWorkQueue.poWorkqueue );
-
-  
-   lcdOff();
-
-  
-   releasePort();
+   emulatorDestroy();
+   pcf8574DriverUnregister();
+#ifdef __NO_DEV_TREE
+   platform_device_unregister( global.pPlatformDevice );
+#endif
+   /*
+    * Invokes onRemove() for each display.
+    */
+   platform_driver_unregister( &mg_platformDriver );
+#ifdef CONFIG_DEBUG_FS
+   debugfs_remove_recursive( global.pDebugFsDir );
+#endif
+   destroy_workqueue( global.poWorkqueue );
 #ifdef CONFIG_PROC_FS
    remove_proc_entry( PROC_FS_NAME, NULL );
 #endif
-   device_destroy( global.pClass, global.deviceNumber );
    class_destroy( global.pClass );
-   cdev_del( global.pObject );
-   unregister_chrdev_region( global.deviceNumber, 1 );
-   kfree( global.oBuffer.pData );
+   unregister_chrdev_region( global.deviceNumber, ARRAY_SIZE( global.apLcd ) );
 }
 
 /*-----------------------------------------------------------------------------
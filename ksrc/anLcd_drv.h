@@ -19,22 +19,144 @@
 #include <linux/module.h>
 #include <linux/fs.h>
 #include <linux/cdev.h>
+#include <linux/kref.h>
 #include <linux/device.h>
 #include <linux/workqueue.h>
 #include <linux/delay.h>
 #include <linux/gpio.h>
+#include <linux/gpio/consumer.h>
+#include <linux/pinctrl/pinconf-generic.h>
 #include <linux/sched.h>
 #include <linux/wait.h>
 #include <linux/uaccess.h>
+#include <linux/platform_device.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/poll.h>
+#include <linux/uio.h>
+#include <linux/kfifo.h>
+#include <linux/log2.h>
+#include <linux/scatterlist.h>
+#include <linux/i2c.h>
 #ifdef CONFIG_PROC_FS
    #include <linux/proc_fs.h>
    #include <linux/seq_file.h>
 #endif
+#ifdef CONFIG_DEBUG_FS
+   #include <linux/debugfs.h>
+   #include <linux/spinlock.h>
+#endif
 
 #include "an_disp_ioctl.h"
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 16, 0)
+   typedef unsigned int __poll_t;
+   #define EPOLLIN     POLLIN
+   #define EPOLLPRI    POLLPRI
+   #define EPOLLOUT    POLLOUT
+   #define EPOLLRDNORM POLLRDNORM
+   #define EPOLLWRNORM POLLWRNORM
+#endif
+
 #define DEVICE_BASE_FILE_NAME KBUILD_MODNAME
 
+#if !defined( CONFIG_OF ) || defined( CONFIG_AN_LCD_NO_DEV_TREE )
+  #define __NO_DEV_TREE
+#endif
+
+#if !defined( CONFIG_AN_LCD_MAX_DEVICES ) || defined(__DOXYGEN__)
+   /*! @brief Maximum number of displays handled by this driver. */
+   #define CONFIG_AN_LCD_MAX_DEVICES 4
+#endif
+
+#if !defined( CONFIG_AN_LCD_FIFO_SIZE ) || defined(__DOXYGEN__)
+   /*! @brief Default size in bytes of the write-FIFO of each display. */
+   #define CONFIG_AN_LCD_FIFO_SIZE 256
+#endif
+#if (CONFIG_AN_LCD_FIFO_SIZE & (CONFIG_AN_LCD_FIFO_SIZE - 1)) != 0
+   #error CONFIG_AN_LCD_FIFO_SIZE has to be a power of two!
+#endif
+
+#if !defined( CONFIG_AN_LCD_REFRESH_MS ) || defined(__DOXYGEN__)
+   /*!
+    * @brief Default refresh-interval in milliseconds, 0 means each write
+    *        becomes flushed immediately.
+    */
+   #define CONFIG_AN_LCD_REFRESH_MS 0
+#endif
+
+/*! @brief Upper limit of the refresh-interval in milliseconds. */
+#define LCD_MAX_REFRESH_MS 10000
+
+#if !defined( CONFIG_TLCD_CLK_DELAY ) || defined(__DOXYGEN__)
+   /*!
+    * @brief Default and upper limit of the delay between the edges of the
+    *        bus-signals in microseconds.
+    */
+   #define CONFIG_TLCD_CLK_DELAY 50
+#endif
+
+/*! @brief Upper limit of the CLK-delay in nanoseconds. */
+#define LCD_MAX_CLK_DELAY_NS (CONFIG_TLCD_CLK_DELAY * 1000)
+
+#if !defined( CONFIG_AN_LCD_CLK_MARGIN ) || defined(__DOXYGEN__)
+   /*!
+    * @brief Safety margin in percent which becomes added to the shortest
+    *        CLK-delay found by the calibration.
+    */
+   #define CONFIG_AN_LCD_CLK_MARGIN 100
+#endif
+
+#if !defined( CONFIG_AN_LCD_MAX_SPIN_NS ) || defined(__DOXYGEN__)
+   /*!
+    * @brief Longest delay in nanoseconds which becomes made by busy-spinning,
+    *        longer delays becomes made by sleeping.
+    *
+    * Below about ten microseconds the costs of a context-switch and the
+    * wakeup-latency exceeds the delay itself, so the edges of the
+    * bus-signals remains spinning, see Documentation/timers/timers-howto.
+    */
+   #define CONFIG_AN_LCD_MAX_SPIN_NS 10000
+#endif
+
+/*!
+ * @brief A sleep may be extended by this fraction of its duration, so the
+ *        hrtimer-subsystem can coalesce the wakeup with other timers.
+ */
+#define LCD_SLEEP_SLACK_DIV 4
+
+/*!
+ * @brief Waits of at least this duration in nanoseconds becomes made by
+ *        msleep(), see Documentation/timers/timers-howto.
+ */
+#define LCD_MSLEEP_MIN_NS (20 * NSEC_PER_MSEC)
+
+/*!
+ * @brief The calibration stops when the interval between the longest failed
+ *        and the shortest passed CLK-delay is smaller than this value
+ *        in nanoseconds.
+ */
+#define LCD_CLK_CALIBRATE_RESOLUTION_NS 100
+
+/*!
+ * @brief Number of consecutive passed bus-verifications which are necessary
+ *        to accept a CLK-delay during the calibration.
+ */
+#define LCD_CLK_CALIBRATE_PASSES 4
+
+#ifdef CONFIG_AN_LCD_BUS_CAPTURE
+  #ifndef CONFIG_DEBUG_FS
+    #error CONFIG_AN_LCD_BUS_CAPTURE requires CONFIG_DEBUG_FS!
+  #endif
+  #if !defined( CONFIG_AN_LCD_BUS_CAPTURE_SIZE ) || defined(__DOXYGEN__)
+    /*! @brief Number of signal-changes in the capture ring-buffer. */
+    #define CONFIG_AN_LCD_BUS_CAPTURE_SIZE 8192
+  #endif
+  #if (CONFIG_AN_LCD_BUS_CAPTURE_SIZE & (CONFIG_AN_LCD_BUS_CAPTURE_SIZE - 1)) != 0
+    #error CONFIG_AN_LCD_BUS_CAPTURE_SIZE has to be a power of two!
+  #endif
+#endif
+
 #ifdef TO_STRING_LITERAL
    #undef TO_STRING_LITERAL
 #endif
@@ -73,10 +195,21 @@
 #define INFO_MESSAGE( constStr, n... ) \
    printk( KERN_INFO DEVICE_BASE_FILE_NAME ": " constStr, ## n )
 
+#define WARNING_MESSAGE( constStr, n... ) \
+   printk( KERN_WARNING DEVICE_BASE_FILE_NAME ": " constStr, ## n )
+
 /* End of message helper macros for "dmesg" ++++++++***************************/
 
 #define ASSERT( condition ) BUG_ON( !(condition) )
 
+#if defined( CONFIG_AN_LCD_VERIFY_ADDRESS ) || defined(__DOXYGEN__)
+   /*!
+    * @brief Compares the imitated address-counter with the one of the
+    *        display-controller, see lcdVerifyAddress() in hd44780Display.c.
+    */
+   #define _LCD_VERIFY_ADDRESS
+#endif
+
 typedef u8   BYTE;
 typedef u16  WORD;
 typedef bool BOOL;
@@ -93,12 +226,63 @@ typedef enum
    OUTPUT_HIGH
 } IO_INIT_T;
 
+/*!
+ * @brief Kind of driving the GPIO-pins.
+ */
+typedef enum
+{
+   /*! @brief Open-drain imitated by switching the direction of the pin. */
+   OPEN_DRAIN_EMULATED,
+   /*! @brief Open-drain supported by the gpio-chip, only values becomes set. */
+   OPEN_DRAIN,
+   /*! @brief Push-pull, e.g. for boards with level-shifters. */
+   PUSH_PULL
+} DRIVE_T;
+
+/*!
+ * @brief Timing-profile of a display-controller, datasheet-values in
+ *        nanoseconds resp. milliseconds.
+ *
+ * The bus-signals rs and r/w becomes set setupNs before the rising edge
+ * of en, setupNs is also the low-time of en between two nibbles. The
+ * high-time of en consists of two times pulseNs, the data becomes written
+ * resp. read between them. The execution times are used in write-only mode
+ * instead of polling the busy-flag.
+ */
+typedef struct
+{
+   const char*  name;      /*!<@brief Value of property "controller" */
+   unsigned int setupNs;   /*!<@brief Max( tAS, tcycE - PWEH ) */
+   unsigned int pulseNs;   /*!<@brief Max( PWEH / 2, tDSW, tDDR ) */
+   unsigned int commandNs; /*!<@brief Execution time of instructions */
+   unsigned int dataNs;    /*!<@brief Write data to RAM inclusive tADD */
+   unsigned int clearNs;   /*!<@brief Clear display and return home */
+   unsigned int initMs;    /*!<@brief Wait after power on */
+} LCD_TIMING_T;
+
+/*!
+ * @brief Origin of the CLK-delay of a display.
+ */
+typedef enum
+{
+   /*! @brief CONFIG_TLCD_CLK_DELAY, e.g. in write-only mode. */
+   CLK_DEFAULT,
+   /*! @brief Found by the calibration at initialization. */
+   CLK_CALIBRATED,
+   /*! @brief Property "clk-delay-ns" of the device-tree. */
+   CLK_DEVICE_TREE,
+   /*! @brief Written in /sys/class/anLcd/anLcd<minor>/clkDelayNs. */
+   CLK_SYSFS
+} CLK_SOURCE_T;
+
 typedef struct
 {
    const char* name;
    int         number;
    IO_INIT_T   init;
    BOOL        initialized;
+   struct gpio_desc* pDesc;
+   DRIVE_T     drive;
 } LCD_GPIO_PIN_T;
 
 typedef struct
@@ -107,50 +291,499 @@ typedef struct
    u8             mask;
 } LCD_DATA_IO_T;
 
+/*!
+ * @brief Number of the data-pins D0 till D3, which are used in 8-bit
+ *        mode only.
+ */
+#define LCD_LOW_DATA_PINS 4
+
 typedef struct
 {
    LCD_GPIO_PIN_T rs;
    LCD_GPIO_PIN_T rw;
    LCD_GPIO_PIN_T en;
-   LCD_DATA_IO_T data[4];
-   LCD_GPIO_PIN_T* list[7];
+   /*!
+    * @brief Data-pins D4 till D7 followed by D0 till D3, the latter are
+    *        used in 8-bit mode only.
+    */
+   LCD_DATA_IO_T data[8];
+   LCD_GPIO_PIN_T* list[11];
+   /*!
+    * @brief Number of used data-pins, 4 or 8, selected at probe-time.
+    */
+   unsigned int  dataCount;
+   /*!
+    * @brief Bits of the byte which are transferred by the used data-pins.
+    */
+   u8            dataMask;
+   /*!
+    * @brief Descriptors of the used data-pins for gpiod_set_array_value()
+    *        and gpiod_get_array_value(), so all data-pins becomes accessed
+    *        by a single call.
+    */
+   struct gpio_desc* dataDesc[8];
+   /*!
+    * @brief Kind of driving of all data-pins.
+    */
+   DRIVE_T       dataDrive;
+   /*!
+    * @brief True when the data-pins are switched as outputs in push-pull
+    *        mode resp. at least one data-pin is driven low in the mode
+    *        OPEN_DRAIN_EMULATED.
+    */
+   bool          dataIsOutput;
+   /*!
+    * @brief Level of rs, true when the data-register is selected.
+    */
+   bool          isData;
 } LCD_IO_PORT_T;
 
+#define LCD_DDRAM_SIZE  0x80
+#define LCD_CGRAM_CHARS 8
+
+/*!
+ * @brief RAM-copy of the memory of the display-controller.
+ *
+ * Becomes updated by each write-access to the controller, so the content
+ * of the display can be read without any bus-access.
+ */
 typedef struct
 {
-   size_t capacity;
-   size_t len;
-   u8*    pData;
-} BUFFER_T;
+   u8               ddRam[LCD_DDRAM_SIZE];
+   LCD_CGRAM_CHAR_T cgRam[LCD_CGRAM_CHARS];
+   int              addr;    /*!<@brief Copy of the address-counter */
+   bool             isCgRam; /*!<@brief Address-counter points in CG-RAM */
+   u8               displayState;
+} LCD_SHADOW_T;
 
 /*!
- * @brief Object-type of private-data for each driver-instance.
+ * @brief Screen-model, the content which shall be displayed.
+ *
+ * Write-accesses becomes applied to this model at first and the
+ * differences to LCD_SHADOW_T becomes transferred to the display
+ * by lcdFlush().
+ */
+typedef struct
+{
+   u8               ddRam[LCD_DDRAM_SIZE];
+   int              addr;    /*!<@brief Cursor position as DD-RAM address */
+} LCD_SCREEN_T;
+
+/*!
+ * @brief Contention of a lock: number of acquisitions which had to wait
+ *        and the sum of the waiting times.
+ */
+typedef struct
+{
+   u64          contended;
+   u64          waitNs;
+} LCD_LOCK_STATISTIC_T;
+
+/*!
+ * @brief Runtime statistics of a display, shown in /proc/driver/anLcd.
+ *
+ * Each counter becomes incremented under the lock which it belongs to:
+ * bytesWritten, fifoHighWater, writeLock and coalesced under oWriteMutex,
+ * stateLock under oStateMutex and all other under oBusMutex, so no atomic
+ * operations are necessary. A reader gets a snapshot which can be slightly
+ * inconsistent.
+ */
+typedef struct
+{
+   u64          bytesWritten;  /*!<@brief Bytes accepted by write() */
+   u64          chars;         /*!<@brief Characters sent to the controller */
+   u64          addressCmds;   /*!<@brief Set-address commands */
+   u64          addressSkips;  /*!<@brief Set-address commands not needed */
+   u64          busyReads;     /*!<@brief Reads of busy-flag and address */
+   u64          polls;         /*!<@brief Repeated busy-flag reads */
+   u64          pollTimeouts;  /*!<@brief Exhaustions of CONFIG_TLCD_MAX_POLL */
+   u64          reinits;       /*!<@brief Re-initializations after errors */
+   u64          coalesced;     /*!<@brief Writes flushed by a foreign flush */
+   u64          delayNs;       /*!<@brief Sum of all busy-waits in ns */
+   u64          sleepNs;       /*!<@brief Sum of all sleeps in ns */
+   u64          i2cTransfers;  /*!<@brief I2C-transactions to a PCF8574 */
+   unsigned int fifoHighWater; /*!<@brief Maximum fill-level of the FIFO */
+   LCD_LOCK_STATISTIC_T writeLock; /*!<@brief Contention of oWriteMutex */
+   LCD_LOCK_STATISTIC_T stateLock; /*!<@brief Contention of oStateMutex */
+   LCD_LOCK_STATISTIC_T busLock;   /*!<@brief Contention of oBusMutex */
+} LCD_STATISTIC_T;
+
+#if defined( CONFIG_DEBUG_FS ) || defined(__DOXYGEN__)
+/*!
+ * @brief Number of buckets of a latency-histogram, the bucket i counts
+ *        the durations from 2^i till 2^(i+1)-1 nanoseconds.
+ */
+#define LCD_HISTOGRAM_BUCKETS 32
+
+/*!
+ * @brief Number of ioctl-histograms, the index is the command-number
+ *        _IOC_NR() of the ioctl-command.
+ */
+#define LCD_IOCTL_HISTOGRAMS (_IOC_NR( AN_DISPLAY_IOC_GET_REFRESH ) + 1)
+
+/*!
+ * @brief Maximum number of write()-calls whose latency becomes measured
+ *        at the same time.
+ */
+#define LCD_WRITE_STAMPS 16
+
+/*!
+ * @brief Latency-histogram with logarithmic buckets.
  */
 typedef struct
+{
+   unsigned long count[LCD_HISTOGRAM_BUCKETS];
+   unsigned long samples;
+   u64           sum; /*!<@brief Sum of all durations in ns */
+   u64           max; /*!<@brief Longest duration in ns */
+} LCD_HISTOGRAM_T;
+
+typedef struct
+{
+   u64 time; /*!<@brief Time-stamp in ns of the entry in write() */
+   u64 end;  /*!<@brief LCD_STATISTIC_T::bytesWritten after this write() */
+} LCD_WRITE_STAMP_T;
+
+/*!
+ * @brief Latency-histograms of a display, readable in the debug-file-system.
+ */
+typedef struct
+{
+   struct dentry*    pDir;
+   LCD_HISTOGRAM_T   write; /*!<@brief From write() till on the display */
+   LCD_HISTOGRAM_T   ioctl[LCD_IOCTL_HISTOGRAMS];
+   LCD_HISTOGRAM_T   bus;   /*!<@brief Each byte by lcdSetData() */
+   /*!
+    * @brief Ring-buffer of the time-stamps of write()-calls whose data
+    *        are not on the display yet.
+    *
+    * Filled by onWriteIter() and emptied by onWorkqueueWrite(), when it's
+    * full a write() becomes not measured.
+    * stampLock protects the histograms as well, so a reset or a read in
+    * the debug-file-system doesn't meet a half updated one.
+    */
+   spinlock_t        stampLock;
+   LCD_WRITE_STAMP_T aStamp[LCD_WRITE_STAMPS];
+   unsigned int      stampHead;
+   unsigned int      stampTail;
+   u64               flushed; /*!<@brief Written bytes flushed to display */
+} LCD_LATENCY_T;
+#endif /* if defined( CONFIG_DEBUG_FS ) || defined(__DOXYGEN__) */
+
+#if defined( CONFIG_AN_LCD_BUS_CAPTURE ) || defined(__DOXYGEN__)
+/*!
+ * @defgroup LCD_CAPTURE Signal-bits of the bus-capture
+ * @{
+ */
+#define LCD_CAPTURE_RS     0x0001
+#define LCD_CAPTURE_RW     0x0002
+#define LCD_CAPTURE_EN     0x0004
+#define LCD_CAPTURE_DATA_Z 0x0008 /*!<@brief Data-pins released */
+#define LCD_CAPTURE_D0     0x0010
+#define LCD_CAPTURE_DATA   0x0FF0 /*!<@brief D0 till D7 */
+#define LCD_CAPTURE_DATA_SHIFT 4
+/*! @} */
+
+/*!
+ * @brief Levels of all bus-signals after a change.
+ */
+typedef struct
+{
+   u64 time;  /*!<@brief Time-stamp in ns */
+   u16 value; /*!<@brief Levels of the signals LCD_CAPTURE_... */
+   u16 known; /*!<@brief Signals with known levels */
+} LCD_CAPTURE_ITEM_T;
+
+/*!
+ * @brief Capture of the bus-signals, readable as VCD-file in the
+ *        debug-file-system.
+ *
+ * The bus becomes accessed by one task at the same time only, so the
+ * ring-buffer has a single producer and needs no lock. Readers make a
+ * copy and discard the items overwritten in the meantime.
+ */
+typedef struct
+{
+   bool                enabled;
+   LCD_CAPTURE_ITEM_T  current;  /*!<@brief Current levels */
+   unsigned int        head;     /*!<@brief Number of all recorded items */
+   LCD_CAPTURE_ITEM_T* pRing;    /*!<@brief CONFIG_AN_LCD_BUS_CAPTURE_SIZE items */
+} LCD_CAPTURE_T;
+#endif /* if defined( CONFIG_AN_LCD_BUS_CAPTURE ) || defined(__DOXYGEN__) */
+
+#if defined( CONFIG_AN_LCD_PCF8574 ) || defined(__DOXYGEN__)
+/*!
+ * @brief Maximum number of port-bytes which becomes collected before they
+ *        are sent to the PCF8574.
+ */
+#define LCD_PCF8574_BUFFER_SIZE 32
+
+/*!
+ * @brief Port of a display connected via a PCF8574 I2C-backpack.
+ *
+ * Each change of the bus-signals becomes a byte for the port of the
+ * I/O-expander. These bytes becomes collected and sent by a single
+ * I2C-transaction before the driver waits for the display-controller or
+ * reads from it, so the I2C-bus paces the edges of the bus-signals.
+ */
+typedef struct
+{
+   struct i2c_client* pClient;
+   /*!
+    * @brief The adapter supports plain I2C-transfers, otherwise each byte
+    *        becomes sent by its own SMBus-transaction, e.g. by i2c-stub.
+    */
+   bool         isPlainI2c;
+   /*!
+    * @brief Duration of a byte on the I2C-bus in nanoseconds, short waits
+    *        for the display-controller becomes made by repeating the
+    *        port-byte instead of sleeping.
+    */
+   unsigned int byteNs;
+   u8           port;  /*!<@brief Levels of P0 till P7 incl. pending bytes */
+   unsigned int count; /*!<@brief Number of pending bytes in aBuffer */
+   u8           aBuffer[LCD_PCF8574_BUFFER_SIZE];
+} LCD_PCF8574_T;
+#endif /* if defined( CONFIG_AN_LCD_PCF8574 ) || defined(__DOXYGEN__) */
+
+#if defined( CONFIG_AN_LCD_EMULATOR ) || defined(__DOXYGEN__)
+/*!
+ * @brief Display-controller imitated in RAM.
+ *
+ * Instructions and data becomes applied at once, so the busy-flag is
+ * never set and no wait is necessary.
+ */
+typedef struct
+{
+   u8           ddRam[LCD_DDRAM_SIZE];
+   u8           cgRam[LCD_CGRAM_CHARS * sizeof( LCD_CGRAM_CHAR_T )];
+   u8           addr;     /*!<@brief Address-counter */
+   bool         isCgRam;  /*!<@brief Address-counter points in CG-RAM */
+   bool         twoLines; /*!<@brief Set by the function-set instruction */
+   u8           displayState;
+   u64          instructions;
+} LCD_EMULATOR_T;
+#endif /* if defined( CONFIG_AN_LCD_EMULATOR ) || defined(__DOXYGEN__) */
+
+struct LCD_OBJ_T;
+struct seq_file;
+
+/*!
+ * @brief Operations of the transport which connects a display, e.g.
+ *        GPIO-pins, a PCF8574 I2C-backpack or the emulator.
+ *
+ * The core in hd44780Display.c accesses the display-controller by these
+ * operations only, so each transport can transfer whole nibbles resp.
+ * bytes as fast as its bus allows. They becomes invoked under oBusMutex.
+ * Instruction or data is selected by the argument isData (pin rs).
+ */
+typedef struct
+{
+   const char* name; /*!<@brief Shown in /proc/driver/anLcd */
+   /*!
+    * @brief Sets the idle-levels of the bus-signals before the
+    *        initialization of the display-controller.
+    */
+   void (*idle)( struct LCD_OBJ_T* pLcd );
+   /*!
+    * @brief A single enable-strobe, transfers the low nibble in 4-bit mode
+    *        resp. the whole byte in 8-bit mode. Used for the
+    *        synchronization at initialization.
+    */
+   void (*writeNibble)( struct LCD_OBJ_T* pLcd, bool isData, u8 data );
+   /*!
+    * @brief Transfers an instruction resp. a data-byte.
+    */
+   void (*writeByte)( struct LCD_OBJ_T* pLcd, bool isData, u8 data );
+   /*!
+    * @brief Reads busy-flag and address-counter resp. a data-byte.
+    */
+   u8   (*readByte)( struct LCD_OBJ_T* pLcd, bool isData );
+   /*!
+    * @brief Waits the execution time of the display-controller in
+    *        nanoseconds.
+    */
+   void (*delay)( struct LCD_OBJ_T* pLcd, unsigned int ns );
+   /*!
+    * @brief Finishes pending transfers before the bus becomes released,
+    *        can be NULL.
+    */
+   void (*flush)( struct LCD_OBJ_T* pLcd );
+#if defined( CONFIG_PROC_FS ) || defined(__DOXYGEN__)
+   /*!
+    * @brief Shows the properties of the transport in /proc/driver/anLcd.
+    */
+   void (*show)( struct LCD_OBJ_T* pLcd, struct seq_file* pSeqFile );
+#endif
+   /*!
+    * @brief The edges of the bus-signals are timed by
+    *        LCD_OBJ_T::clkDelayNs, so it can be calibrated.
+    */
+   bool hasClkDelay;
+} LCD_TRANSPORT_T;
+
+typedef struct 
+{
+   struct work_struct       oInit;
+   struct delayed_work      oWrite; /*!<@brief Delayed by the refresh-interval */
+} WORK_QUEUE_T;
+
+typedef struct WAIT_QUEUE_T
+{
+   wait_queue_head_t queue;
+} WAIT_QUEUE_T;
+
+/*!
+ * @brief Object-type of private-data for each driver-instance.
+ *
+ * Each display connected to the system has its own object with its own
+ * device-file, wait-queue, buffer and work-items, so accesses to different
+ * displays don't block each other.
+ */
+typedef struct LCD_OBJ_T
 {
    int           minor;
    atomic_t      openCount;
+   /*!
+    * @brief References of the device-driver and of each opened
+    *        device-file, the object becomes freed by the last one.
+    */
+   struct kref   oRef;
+   /*!
+    * @brief The device is unbound but device-files are still open, so
+    *        any further access becomes rejected by -ENODEV.
+    *        Set under oWriteMutex and oBusMutex.
+    */
+   bool          isRemoved;
    int           maxX;
    int           maxY;
    bool          isInitialized;
+   /*!
+    * @brief The display was initialized at least once, so each further
+    *        initialization becomes counted as re-initialization.
+    */
+   bool          wasInitialized;
    bool          autoScroll;
    bool          lastChar;
+   bool          verifyRead;
+   bool          writeOnly; /*!<@brief Pin r/w tied to ground, no busy-flag */
+   bool          pushPull;  /*!<@brief GPIOs in push-pull instead open-drain */
+   /*!
+    * @brief Delay between the edges of the bus-signals in nanoseconds,
+    *        changed under oBusMutex only.
+    */
+   unsigned int  clkDelayNs;
+   CLK_SOURCE_T  clkSource;
+   /*!
+    * @brief Failure of the CLK-calibration already reported, so a
+    *        re-initialization doesn't repeat it.
+    */
+   bool          clkCalibrateWarned;
+   const LCD_TIMING_T* pTiming; /*!<@brief Profile of the controller */
    BYTE          displayState;
+   int           putchState;      /*!<@brief State of the escape-parser */
+   unsigned int  escParameter[2]; /*!<@brief Parameter of escape-sequences */
+   size_t        escIndex;
+   LCD_SCREEN_T  oScreen;
+   LCD_SHADOW_T  oShadow;
    LCD_IO_PORT_T port;
+   const LCD_TRANSPORT_T* pTransport; /*!<@brief Connection of the display */
+   /*!
+    * @brief Allocated separately, because an opened device-file can
+    *        hold it longer than this object.
+    */
+   struct cdev*  pCdev;
+   struct device* pDevice;       /*!<@brief Device of /dev/anLcd<minor> */
+   WAIT_QUEUE_T  oWaitQueue;
+   WORK_QUEUE_T  oWorkQueue;
+   /*!
+    * @brief Write-FIFO, filled by onWriteIter() and drained by the
+    *        escape-parser under oStateMutex, see lockState().
+    *
+    * The kfifo is lock-free for a single producer and a single consumer
+    * only, therefore concurrent writers becomes serialized by oWriteMutex.
+    */
+   struct kfifo  oFifo;
+   /*!
+    * @brief Serializes concurrent writers, so the bytes of a write()
+    *        becomes not mixed with the bytes of another one.
+    */
+   struct mutex  oWriteMutex;
+   /*!
+    * @brief Serializes the accesses to the display-controller and to its
+    *        RAM-copy oShadow, e.g. lcdFlush(), lcdInit() and read-back.
+    */
+   struct mutex  oBusMutex;
+   /*!
+    * @brief Protects the screen-model, the escape-parser and the display
+    *        state. It becomes held for memory-operations only, so
+    *        state-changes don't wait for a running flush.
+    * @note Lock-order: oBusMutex before oStateMutex.
+    */
+   struct mutex  oStateMutex;
+   /*!
+    * @brief Snapshot of the screen-model taken under oStateMutex and
+    *        transferred to the display by lcdFlush() under oBusMutex.
+    */
+   LCD_SCREEN_T  oFrame;
+   BYTE          frameDisplayState;
+   u64           frameBytes; /*!<@brief Written bytes contained in oFrame */
+   /*!
+    * @brief Bytes taken from the write-FIFO by the escape-parser,
+    *        protected by oStateMutex.
+    */
+   u64           bytesParsed;
+   unsigned long lastFlush;  /*!<@brief Time of the last flush in jiffies */
+   /*!
+    * @brief Minimum time between two flushes of written characters in
+    *        milliseconds, changes within this window becomes collected.
+    */
+   unsigned int  refreshMs;
+   /*!
+    * @brief The screen-model was changed by a write() since the last
+    *        snapshot, protected by oStateMutex.
+    */
+   bool          dirty;
+   /*!
+    * @brief Becomes incremented each time written content was flushed
+    *        to the display.
+    */
+   atomic_t      flushCount;
+   LCD_STATISTIC_T oStatistic;
+#ifdef CONFIG_DEBUG_FS
+   LCD_LATENCY_T oLatency;
+#endif
+#ifdef CONFIG_AN_LCD_BUS_CAPTURE
+   LCD_CAPTURE_T oCapture;
+#endif
+#ifdef CONFIG_AN_LCD_PCF8574
+   LCD_PCF8574_T oPcf8574;
+#endif
+#ifdef CONFIG_AN_LCD_EMULATOR
+   LCD_EMULATOR_T oEmulator;
+#endif
 } LCD_OBJ_T;
 
-typedef struct 
-{
-   struct workqueue_struct* poWorkqueue;
-   struct work_struct       oInit;
-   struct work_struct       oWrite;
-} WORK_QUEUE_T;
-
-typedef struct WAIT_QUEUE_T
+/*!
+ * @brief Object-type of private-data for each opened device-file.
+ */
+typedef struct
 {
-   volatile bool     bussy;
-   wait_queue_head_t queue;
-} WAIT_QUEUE_T;
+   LCD_OBJ_T*    pLcd;
+   /*!
+    * @brief Value of LCD_OBJ_T::flushCount at the last read(), or at
+    *        opening, for EPOLLIN of poll().
+    */
+   int           readFlushCount;
+   /*!
+    * @brief Value of LCD_OBJ_T::flushCount at the last read() resp.
+    *        ioctl() of this file, or at opening, for EPOLLPRI of poll().
+    *
+    * Independent of CONFIG_AN_LCD_READBACK, so EPOLLPRI becomes consumed
+    * by an ioctl() as well.
+    */
+   int           seenFlushCount;
+} LCD_FILE_T;
 
 /*!
  * @brief Structure of global variables.
@@ -162,21 +795,77 @@ typedef struct WAIT_QUEUE_T
 typedef struct
 {
    dev_t             deviceNumber;
-   struct cdev*      pObject;
    struct class*     pClass;
-   WAIT_QUEUE_T      oWaitQueue;
-   WORK_QUEUE_T      oWorkQueue; 
-   LCD_OBJ_T         oLcd;
-   BUFFER_T          oBuffer;
+   /*!
+    * @brief Workqueue shared by all displays.
+    *
+    * It's unbound, so the work-items of different displays can run
+    * concurrently.
+    */
+   struct workqueue_struct* poWorkqueue;
+   /*!
+    * @brief Protects apLcd[] and aMinorReserved[].
+    */
+   struct mutex      oInstanceMutex;
+   /*!
+    * @brief Objects of all probed displays, index is the minor number.
+    *
+    * An object becomes published here not until it is completely
+    * initialized, see registerLcdObject().
+    */
+   LCD_OBJ_T*        apLcd[CONFIG_AN_LCD_MAX_DEVICES];
+   /*!
+    * @brief Minor numbers in use, including the ones of objects which are
+    *        not published in apLcd[] yet.
+    */
+   bool              aMinorReserved[CONFIG_AN_LCD_MAX_DEVICES];
+#ifdef __NO_DEV_TREE
+   struct platform_device* pPlatformDevice;
+#endif
 #ifdef CONFIG_PROC_FS
    struct proc_dir_entry*  poProcFile;
 #endif
+#ifdef CONFIG_DEBUG_FS
+   /*!
+    * @brief Directory of the driver in the debug-file-system.
+    */
+   struct dentry*          pDebugFsDir;
+#endif
 } GLOBAL_T;
 
 extern GLOBAL_T global;
 
-int writeLcdPort( u8 data );
-BYTE readLcdPort( void );
+void setLcdPin( LCD_GPIO_PIN_T* pPin, int value );
+int writeLcdPort( LCD_OBJ_T* pLcd, u8 data );
+void releaseLcdPort( LCD_OBJ_T* pLcd );
+BYTE readLcdPort( LCD_OBJ_T* pLcd );
+void lcdDelayNs( LCD_OBJ_T* pLcd, unsigned int ns );
+const LCD_TIMING_T* findTiming( const char* name );
+LCD_OBJ_T* allocLcdObject( void );
+int registerLcdObject( LCD_OBJ_T* pLcd, struct device* pParent );
+void unregisterLcdObject( LCD_OBJ_T* pLcd );
+void putLcdObject( LCD_OBJ_T* pLcd );
+#ifdef CONFIG_DEBUG_FS
+void lcdLatencyAdd( LCD_OBJ_T* pLcd, LCD_HISTOGRAM_T* pHist, u64 ns );
+#endif
+
+#if defined( CONFIG_AN_LCD_BUS_CAPTURE ) || defined(__DOXYGEN__)
+void lcdCaptureSignal( LCD_OBJ_T* pLcd, unsigned int mask, unsigned int value );
+
+/*!
+ * @brief Records the new levels of the signals given by mask when the
+ *        capture is enabled.
+ */
+#define LCD_CAPTURE( pLcd, mask, value )                                \
+   do                                                                    \
+   {                                                                     \
+      if( unlikely( (pLcd)->oCapture.enabled ) )                         \
+         lcdCaptureSignal( pLcd, mask, value );                          \
+   }                                                                     \
+   while( false )
+#else
+#define LCD_CAPTURE( pLcd, mask, value )
+#endif
 
 #endif /* ifndef _ANLCD_DRV_H */
 /*================================== EOF ====================================*/
@@ -0,0 +1,312 @@
+/*****************************************************************************/
+/*                                                                           */
+/*!   @brief HD44780 compatible display-controller emulated in memory        */
+/*                                                                           */
+/*!      Serves the device-files /dev/anLcd<n> without any hardware, e.g.    */
+/*!      for testing the core and the applications and for measuring the     */
+/*!      overhead of the driver without the bus.                             */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+/*! @file    anLcd_emulator.c                                                */
+/*! @see     anLcd_emulator.h                                                */
+/*! @see     anLcd_drv.c                                                     */
+/*! @author  Ulrich Becker                                                   */
+/*! @date    17.10.2026                                                      */
+/*****************************************************************************/
+/*
+ * Usage e.g.:
+ *    insmod anLcd.ko emulated=2
+ *    echo "Hello world" > /dev/anLcd0
+ *    cat /proc/driver/anLcd
+ */
+#include "anLcd_emulator.h"
+#include "hd44780Display.h"
+#include <linux/slab.h>
+
+#ifdef CONFIG_AN_LCD_EMULATOR
+
+/*!
+ * @brief Dimensions of the emulated displays.
+ */
+#define EMULATOR_X 16
+#define EMULATOR_Y 2
+
+/*!
+ * @brief Last address of the first line in DD-RAM resp. begin of the
+ *        second line in 2-line mode, in 1-line mode the last address of
+ *        the whole DD-RAM.
+ */
+#define EMULATOR_LINE_END_2   0x27
+#define EMULATOR_LINE_BEGIN_2 0x40
+#define EMULATOR_LINE_END_1   0x4F
+
+#define EMULATOR_CGRAM_MASK \
+   (LCD_CGRAM_CHARS * sizeof( LCD_CGRAM_CHAR_T ) - 1)
+
+static unsigned int mg_emulated = 0;
+module_param_named( emulated, mg_emulated, uint, S_IRUGO );
+MODULE_PARM_DESC( emulated, "Number of displays emulated in memory, 0: none" );
+
+/*!
+ * @brief Objects of the emulated displays, becomes removed by
+ *        emulatorDestroy().
+ */
+static LCD_OBJ_T* mg_apEmulated[CONFIG_AN_LCD_MAX_DEVICES];
+
+/* Transport begin ***********************************************************/
+/*!----------------------------------------------------------------------------
+ * @brief Increments the address-counter like the display-controller.
+ *
+ * In 2-line mode the DD-RAM consists of the ranges 0x00 till 0x27 and
+ * 0x40 till 0x67.
+ */
+static void emulatorIncrement( LCD_EMULATOR_T* pEmu )
+{
+   if( pEmu->isCgRam )
+   {
+      pEmu->addr = (pEmu->addr + 1) & EMULATOR_CGRAM_MASK;
+      return;
+   }
+   if( !pEmu->twoLines )
+   {
+      pEmu->addr = (pEmu->addr >= EMULATOR_LINE_END_1)? 0 : pEmu->addr + 1;
+      return;
+   }
+   switch( pEmu->addr )
+   {
+      case EMULATOR_LINE_END_2:
+         pEmu->addr = EMULATOR_LINE_BEGIN_2;
+         break;
+      case EMULATOR_LINE_BEGIN_2 + EMULATOR_LINE_END_2:
+         pEmu->addr = 0;
+         break;
+      default:
+         pEmu->addr++;
+         break;
+   }
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Executes an instruction of the display-controller.
+ *
+ * The instruction becomes decoded by its highest set bit like the
+ * controller does. Entry-mode and shift are not emulated, the core uses
+ * the increment without shift only.
+ */
+static void emulatorInstruction( LCD_EMULATOR_T* pEmu, u8 data )
+{
+   pEmu->instructions++;
+   if( (data & 0x80) != 0 )
+   { /* Set DD-RAM address */
+      pEmu->addr = data & (LCD_DDRAM_SIZE - 1);
+      pEmu->isCgRam = false;
+   }
+   else if( (data & 0x40) != 0 )
+   { /* Set CG-RAM address */
+      pEmu->addr = data & EMULATOR_CGRAM_MASK;
+      pEmu->isCgRam = true;
+   }
+   else if( (data & 0x20) != 0 )
+   { /* Function set */
+      pEmu->twoLines = (data & 0x08) != 0;
+   }
+   else if( (data & 0x10) != 0 )
+   { /* Cursor or display shift, not emulated */
+   }
+   else if( (data & LCD_FLAG_CMD_ON_OFF_CTRL) != 0 )
+   {
+      pEmu->displayState = data & (LCD_FLAG_DISPLAY_ON |
+                                   LCD_FLAG_CURSOR_ON |
+                                   LCD_FLAG_BLINK_ON);
+   }
+   else if( (data & 0x04) != 0 )
+   { /* Entry mode set, not emulated */
+   }
+   else if( (data & 0x02) != 0 )
+   { /* Return home */
+      pEmu->addr = 0;
+      pEmu->isCgRam = false;
+   }
+   else if( data == 0x01 )
+   { /* Clear display */
+      memset( pEmu->ddRam, ' ', sizeof( pEmu->ddRam ) );
+      pEmu->addr = 0;
+      pEmu->isCgRam = false;
+   }
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static void emulatorIdle( LCD_OBJ_T* pLcd )
+{
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Writes an instruction or a data-byte.
+ */
+static void emulatorWriteByte( LCD_OBJ_T* pLcd, bool isData, u8 data )
+{
+   LCD_EMULATOR_T* pEmu = &pLcd->oEmulator;
+
+   if( !isData )
+   {
+      emulatorInstruction( pEmu, data );
+      return;
+   }
+   if( pEmu->isCgRam )
+      pEmu->cgRam[pEmu->addr] = data;
+   else
+      pEmu->ddRam[pEmu->addr] = data;
+   emulatorIncrement( pEmu );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief The emulated display has an 8-bit data-bus, so a single
+ *        enable-strobe transfers the whole byte.
+ */
+static void emulatorWriteNibble( LCD_OBJ_T* pLcd, bool isData, u8 data )
+{
+   emulatorWriteByte( pLcd, isData, data );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Reads the address-counter, the busy-flag is never set, resp. a
+ *        data-byte.
+ */
+static u8 emulatorReadByte( LCD_OBJ_T* pLcd, bool isData )
+{
+   LCD_EMULATOR_T* pEmu = &pLcd->oEmulator;
+   u8 data;
+
+   if( !isData )
+      return pEmu->addr;
+
+   if( pEmu->isCgRam )
+      data = pEmu->cgRam[pEmu->addr];
+   else
+      data = pEmu->ddRam[pEmu->addr];
+   emulatorIncrement( pEmu );
+   return data;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Instructions are executed at once, so nothing to wait.
+ */
+static void emulatorDelay( LCD_OBJ_T* pLcd, unsigned int ns )
+{
+}
+
+#ifdef CONFIG_PROC_FS
+/*!----------------------------------------------------------------------------
+ * @brief Shows the emulated screen, non-printable characters as '.'.
+ */
+static void emulatorShow( LCD_OBJ_T* pLcd, struct seq_file* pSeqFile )
+{
+   LCD_EMULATOR_T* pEmu = &pLcd->oEmulator;
+   unsigned int x, y;
+   u8 c;
+
+   seq_printf( pSeqFile, "Emulator: display %s, %llu instructions\n",
+               ((pEmu->displayState & LCD_FLAG_DISPLAY_ON) != 0)? "on" : "off",
+               pEmu->instructions );
+   for( y = 0; y < pLcd->maxY; y++ )
+   {
+      seq_puts( pSeqFile, "|" );
+      for( x = 0; x < pLcd->maxX; x++ )
+      {
+         c = pEmu->ddRam[(lcdLine2Addr( pLcd, y ) + x) & (LCD_DDRAM_SIZE - 1)];
+         seq_putc( pSeqFile, ((c >= ' ') && (c < 0x7F))? c : '.' );
+      }
+      seq_puts( pSeqFile, "|\n" );
+   }
+}
+#endif
+
+/*!
+ * @brief Transport of the displays emulated in memory.
+ */
+static const LCD_TRANSPORT_T mg_emulatorTransport =
+{
+   .name        = "emulator",
+   .idle        = emulatorIdle,
+   .writeNibble = emulatorWriteNibble,
+   .writeByte   = emulatorWriteByte,
+   .readByte    = emulatorReadByte,
+   .delay       = emulatorDelay,
+   .flush       = NULL,
+#ifdef CONFIG_PROC_FS
+   .show        = emulatorShow,
+#endif
+   .hasClkDelay = false
+};
+/* Transport end *************************************************************/
+
+/*!----------------------------------------------------------------------------
+ * @brief Creates the number of displays given by the module-parameter
+ *        "emulated".
+ *
+ * The emulated displays get the minor-numbers left over by the real ones,
+ * if there are not enough then the number becomes clamped.
+ */
+int emulatorCreate( void )
+{
+   LCD_OBJ_T* pLcd;
+   unsigned int i;
+   int ret;
+
+   for( i = 0; i < min_t( unsigned int, mg_emulated,
+                          ARRAY_SIZE( mg_apEmulated ) ); i++ )
+   {
+      pLcd = allocLcdObject();
+      if( pLcd == NULL )
+      {
+         ret = -ENOMEM;
+         goto L_DESTROY;
+      }
+      pLcd->maxX           = EMULATOR_X;
+      pLcd->maxY           = EMULATOR_Y;
+      pLcd->port.dataCount = 8;
+      pLcd->clkDelayNs     = 0;
+      pLcd->pTransport     = &mg_emulatorTransport;
+      memset( pLcd->oEmulator.ddRam, ' ', sizeof( pLcd->oEmulator.ddRam ) );
+
+      ret = registerLcdObject( pLcd, NULL );
+      if( ret == -ENOSPC )
+      {
+         putLcdObject( pLcd );
+         INFO_MESSAGE( "No free minor-number, %u of %u displays emulated\n",
+                       i, mg_emulated );
+         break;
+      }
+      if( ret != 0 )
+      {
+         putLcdObject( pLcd );
+         goto L_DESTROY;
+      }
+      mg_apEmulated[i] = pLcd;
+   }
+   return 0;
+
+L_DESTROY:
+   emulatorDestroy();
+   return ret;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+void emulatorDestroy( void )
+{
+   unsigned int i;
+
+   for( i = 0; i < ARRAY_SIZE( mg_apEmulated ); i++ )
+   {
+      if( mg_apEmulated[i] == NULL )
+         continue;
+      unregisterLcdObject( mg_apEmulated[i] );
+      putLcdObject( mg_apEmulated[i] );
+      mg_apEmulated[i] = NULL;
+   }
+}
+
+#endif /* ifdef CONFIG_AN_LCD_EMULATOR */
+/*================================== EOF ====================================*/
@@ -0,0 +1,30 @@
+/*****************************************************************************/
+/*                                                                           */
+/*!   @brief HD44780 compatible display-controller emulated in memory        */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+/*! @file    anLcd_emulator.h                                                */
+/*! @see     anLcd_emulator.c                                                */
+/*! @see     anLcd_drv.c                                                     */
+/*! @author  Ulrich Becker                                                   */
+/*! @date    17.10.2026                                                      */
+/*****************************************************************************/
+#ifndef _ANLCD_EMULATOR_H
+#define _ANLCD_EMULATOR_H
+
+#include "anLcd_drv.h"
+
+#if defined( CONFIG_AN_LCD_EMULATOR ) || defined(__DOXYGEN__)
+
+int emulatorCreate( void );
+void emulatorDestroy( void );
+
+#else
+
+static inline int emulatorCreate( void ) { return 0; }
+static inline void emulatorDestroy( void ) {}
+
+#endif /* else if defined( CONFIG_AN_LCD_EMULATOR ) || defined(__DOXYGEN__) */
+
+#endif /* ifndef _ANLCD_EMULATOR_H */
+/*================================== EOF ====================================*/
@@ -0,0 +1,566 @@
+/*****************************************************************************/
+/*                                                                           */
+/*!   @brief HD44780 compatible displays connected via PCF8574 backpack      */
+/*                                                                           */
+/*!      The common I2C-backpacks wire the display as follows:               */
+/*!      P0: rs, P1: r/w, P2: en, P3: backlight, P4..P7: d4..d7              */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+/*! @file    anLcd_pcf8574.c                                                 */
+/*! @see     anLcd_pcf8574.h                                                 */
+/*! @see     anLcd_drv.c                                                     */
+/*! @author  Ulrich Becker                                                   */
+/*! @date    17.10.2026                                                      */
+/*****************************************************************************/
+/*
+ * Test without hardware by the module i2c-stub, which emulates the
+ * SMBus-byte-transfers of the PCF8574:
+ *    modprobe i2c-stub chip_addr=0x27
+ *    echo anLcd-pcf8574-wo 0x27 > /sys/bus/i2c/devices/i2c-<n>/new_device
+ */
+#include "anLcd_pcf8574.h"
+#include "anLcd_dev_tree_names.h"
+#include <linux/slab.h>
+#include <linux/property.h>
+
+#ifdef CONFIG_AN_LCD_PCF8574
+
+/*!
+ * @brief Dimensions of a display instantiated without the properties
+ *        "maxX" and "maxY", e.g. by /sys/bus/i2c/devices/i2c-<n>/new_device.
+ */
+#define PCF8574_DEFAULT_X 16
+#define PCF8574_DEFAULT_Y 2
+
+/*!
+ * @brief Value of i2c_device_id::driver_data for displays whose pin r/w
+ *        is tied to ground resp. can't be read, e.g. i2c-stub.
+ */
+#define PCF8574_ID_WRITE_ONLY 1
+
+/*!
+ * @brief Assumed clock of the I2C-bus when the adapter has no property
+ *        "clock-frequency". It's the fastest mode, so the time of a byte
+ *        becomes never overestimated.
+ */
+#define PCF8574_MAX_BUS_HZ 1000000
+
+/*!
+ * @brief Number of bits on the I2C-bus per byte, including acknowledge.
+ */
+#define PCF8574_BITS_PER_BYTE 9
+
+/*!
+ * @brief Waits for the display-controller up to this number of byte-times
+ *        becomes made by repeating the port-byte in the running
+ *        transaction, longer waits by sleeping.
+ */
+#define PCF8574_MAX_PAD_BYTES 8
+
+/* Transport begin ***********************************************************/
+/*!----------------------------------------------------------------------------
+ * @brief Handles a failed transfer, the display becomes re-initialized
+ *        by the init-work queued in unlockBus().
+ */
+static void pcf8574OnError( LCD_OBJ_T* pLcd, int ret )
+{
+   if( printk_ratelimit() )
+      ERROR_MESSAGE( DEVICE_BASE_FILE_NAME "%d: I2C-transfer failed: %d\n",
+                     pLcd->minor, ret );
+   pLcd->isInitialized = false;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Sends all pending port-bytes.
+ *
+ * Plain I2C-adapters gets all bytes by a single transaction, the PCF8574
+ * takes over each byte at its acknowledge. Pure SMBus-adapters needs a
+ * transaction for each byte.
+ */
+static int pcf8574Send( LCD_OBJ_T* pLcd )
+{
+   LCD_PCF8574_T* pPcf = &pLcd->oPcf8574;
+   unsigned int i;
+   int ret = 0;
+
+   if( pPcf->count == 0 )
+      return 0;
+
+   if( pPcf->isPlainI2c )
+   {
+      ret = i2c_master_send( pPcf->pClient, (const char*)pPcf->aBuffer,
+                             pPcf->count );
+      pLcd->oStatistic.i2cTransfers++;
+      /*
+       * A short count means the PCF8574 has not acknowledged a byte, the
+       * remaining port-bytes would be lost silently.
+       */
+      if( (ret >= 0) && (ret != pPcf->count) )
+         ret = -EIO;
+   }
+   else
+   {
+      for( i = 0; (i < pPcf->count) && (ret >= 0); i++ )
+      {
+         ret = i2c_smbus_write_byte( pPcf->pClient, pPcf->aBuffer[i] );
+         pLcd->oStatistic.i2cTransfers++;
+      }
+   }
+   pPcf->count = 0;
+
+   if( ret < 0 )
+   {
+      pcf8574OnError( pLcd, ret );
+      return ret;
+   }
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Appends a byte to the pending bytes, a full buffer becomes sent
+ *        before.
+ */
+static inline void pcf8574Append( LCD_OBJ_T* pLcd, u8 port )
+{
+   LCD_PCF8574_T* pPcf = &pLcd->oPcf8574;
+
+   if( pPcf->count == ARRAY_SIZE( pPcf->aBuffer ) )
+      pcf8574Send( pLcd );
+   pPcf->aBuffer[pPcf->count++] = port;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Records a new state of the port in the bus-capture, the bits of
+ *        the port are wired in the same order as the signal-bits.
+ */
+static inline void pcf8574Capture( LCD_OBJ_T* pLcd, u8 port )
+{
+   LCD_CAPTURE( pLcd, LCD_CAPTURE_RS | LCD_CAPTURE_RW | LCD_CAPTURE_EN |
+                      LCD_CAPTURE_DATA_Z |
+                      (PCF8574_DATA << LCD_CAPTURE_DATA_SHIFT),
+                (port & (PCF8574_RS | PCF8574_RW | PCF8574_EN)) |
+                (((port & PCF8574_RW) != 0)? LCD_CAPTURE_DATA_Z : 0) |
+                ((port & PCF8574_DATA) << LCD_CAPTURE_DATA_SHIFT) );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Appends a new state of the port to the pending bytes.
+ *
+ * Unchanged states are not sent again.
+ */
+static void pcf8574Put( LCD_OBJ_T* pLcd, u8 port )
+{
+   if( port == pLcd->oPcf8574.port )
+      return;
+   pLcd->oPcf8574.port = port;
+   pcf8574Append( pLcd, port );
+   pcf8574Capture( pLcd, port );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Reads the port by a SMBus-transaction after sending the pending
+ *        bytes.
+ */
+static int pcf8574SmbusRead( LCD_OBJ_T* pLcd, u8* pValue )
+{
+   int ret;
+
+   ret = pcf8574Send( pLcd );
+   if( ret != 0 )
+      return ret;
+   ret = i2c_smbus_read_byte( pLcd->oPcf8574.pClient );
+   pLcd->oStatistic.i2cTransfers++;
+   if( ret < 0 )
+   {
+      pcf8574OnError( pLcd, ret );
+      return ret;
+   }
+   *pValue = ret;
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static inline void pcf8574SetMsg( struct i2c_msg* pMsg,
+                                  struct i2c_client* pClient,
+                                  u16 flags, u16 len, u8* pBuffer )
+{
+   pMsg->addr  = pClient->addr;
+   pMsg->flags = flags;
+   pMsg->len   = len;
+   pMsg->buf   = pBuffer;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Idle-levels of the port: backlight on, data-pins released and
+ *        en low, so the next transfer begins without an edge of en.
+ */
+static void pcf8574Idle( LCD_OBJ_T* pLcd )
+{
+   u8 port = PCF8574_BACKLIGHT | PCF8574_DATA | PCF8574_RS;
+
+   if( !pLcd->writeOnly )
+      port |= PCF8574_RW;
+   pcf8574Put( pLcd, port );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Transfers the low nibble of data by three port-bytes: rs, r/w and
+ *        data before, during and after the pulse of en. The controller
+ *        takes the nibble over at the falling edge.
+ */
+static void pcf8574WriteNibble( LCD_OBJ_T* pLcd, bool isData, u8 data )
+{
+   const u8 port = PCF8574_BACKLIGHT | (isData? PCF8574_RS : 0) |
+                   ((data << 4) & PCF8574_DATA);
+
+   pcf8574Put( pLcd, port );
+   pcf8574Put( pLcd, port | PCF8574_EN );
+   pcf8574Put( pLcd, port );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief The backpack connects the data-pins D4 till D7 only, so each byte
+ *        becomes transferred as two nibbles.
+ */
+static void pcf8574WriteByte( LCD_OBJ_T* pLcd, bool isData, u8 data )
+{
+   pcf8574WriteNibble( pLcd, isData, data >> 4 );
+   pcf8574WriteNibble( pLcd, isData, data );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Reads both nibbles of a byte while en is high.
+ *
+ * The outputs of the PCF8574 are quasi-bidirectional, the data-pins
+ * becomes released by a high-level, which is only a weak pull-up which
+ * the display can pull down.
+ * Plain I2C-adapters makes the pending bytes, both pulses of en and both
+ * readings by a single transaction with repeated starts. The falling edge
+ * of en after the last reading remains pending for the next transfer.
+ */
+static u8 pcf8574ReadByte( LCD_OBJ_T* pLcd, bool isData )
+{
+   LCD_PCF8574_T* pPcf = &pLcd->oPcf8574;
+   const u8 port = PCF8574_BACKLIGHT | PCF8574_RW | PCF8574_DATA |
+                   (isData? PCF8574_RS : 0);
+   u8 aStrobe[2] = { port, port | PCF8574_EN };
+   u8 high = 0;
+   u8 low = 0;
+   struct i2c_msg aMsg[4];
+   int ret;
+
+   pcf8574Put( pLcd, port );
+   pcf8574Put( pLcd, port | PCF8574_EN );
+
+   if( pPcf->isPlainI2c )
+   {
+      pcf8574SetMsg( &aMsg[0], pPcf->pClient, 0, pPcf->count, pPcf->aBuffer );
+      pcf8574SetMsg( &aMsg[1], pPcf->pClient, I2C_M_RD, 1, &high );
+      pcf8574SetMsg( &aMsg[2], pPcf->pClient, 0, ARRAY_SIZE( aStrobe ),
+                     aStrobe );
+      pcf8574SetMsg( &aMsg[3], pPcf->pClient, I2C_M_RD, 1, &low );
+      ret = i2c_transfer( pPcf->pClient->adapter, aMsg, ARRAY_SIZE( aMsg ) );
+      pLcd->oStatistic.i2cTransfers++;
+      pPcf->count = 0;
+      if( (ret >= 0) && (ret != ARRAY_SIZE( aMsg )) )
+         ret = -EIO;
+      if( ret < 0 )
+      {
+         pcf8574OnError( pLcd, ret );
+         return 0;
+      }
+      pcf8574Capture( pLcd, aStrobe[0] );
+      pcf8574Capture( pLcd, aStrobe[1] );
+   }
+   else
+   {
+      if( pcf8574SmbusRead( pLcd, &high ) != 0 )
+         return 0;
+      pcf8574Put( pLcd, port );
+      pcf8574Put( pLcd, port | PCF8574_EN );
+      if( pcf8574SmbusRead( pLcd, &low ) != 0 )
+         return 0;
+   }
+   pcf8574Put( pLcd, port );
+   LCD_CAPTURE( pLcd, PCF8574_DATA << LCD_CAPTURE_DATA_SHIFT,
+                (low & PCF8574_DATA) << LCD_CAPTURE_DATA_SHIFT );
+   return (high & PCF8574_DATA) | ((low & PCF8574_DATA) >> 4);
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Waits for the display-controller.
+ *
+ * A short wait becomes made by repeating the current port-byte, so the
+ * pending bytes becomes not interrupted and the I2C-bus paces the
+ * execution time. Otherwise the pending bytes becomes sent before
+ * sleeping. Each SMBus-byte is a transaction of its own, so the time
+ * between them is unknown.
+ */
+static void pcf8574Delay( LCD_OBJ_T* pLcd, unsigned int ns )
+{
+   LCD_PCF8574_T* pPcf = &pLcd->oPcf8574;
+   unsigned int count;
+
+   if( pPcf->isPlainI2c && (ns <= PCF8574_MAX_PAD_BYTES * pPcf->byteNs) )
+   {
+      for( count = DIV_ROUND_UP( ns, pPcf->byteNs ); count > 0; count-- )
+         pcf8574Append( pLcd, pPcf->port );
+      return;
+   }
+   pcf8574Send( pLcd );
+   lcdDelayNs( pLcd, ns );
+}
+
+/*!----------------------------------------------------------------------------
+ */
+static void pcf8574Flush( LCD_OBJ_T* pLcd )
+{
+   pcf8574Send( pLcd );
+}
+
+#ifdef CONFIG_PROC_FS
+/*!----------------------------------------------------------------------------
+ */
+static void pcf8574Show( LCD_OBJ_T* pLcd, struct seq_file* pSeqFile )
+{
+   LCD_PCF8574_T* pPcf = &pLcd->oPcf8574;
+
+   seq_printf( pSeqFile, "PCF8574: %s address 0x%02x (%s)\n",
+               dev_name( &pPcf->pClient->adapter->dev ),
+               pPcf->pClient->addr,
+               pPcf->isPlainI2c? "i2c" : "smbus" );
+   seq_printf( pSeqFile, "I2C byte time: %u ns\n", pPcf->byteNs );
+   seq_printf( pSeqFile, "I2C transactions: %llu\n",
+               pLcd->oStatistic.i2cTransfers );
+}
+#endif
+
+/*!
+ * @brief Transport of the displays on a PCF8574, the port-bytes of whole
+ *        nibbles becomes collected and sent by one I2C-transaction.
+ */
+static const LCD_TRANSPORT_T mg_pcf8574Transport =
+{
+   .name        = "pcf8574",
+   .idle        = pcf8574Idle,
+   .writeNibble = pcf8574WriteNibble,
+   .writeByte   = pcf8574WriteByte,
+   .readByte    = pcf8574ReadByte,
+   .delay       = pcf8574Delay,
+   .flush       = pcf8574Flush,
+#ifdef CONFIG_PROC_FS
+   .show        = pcf8574Show,
+#endif
+   .hasClkDelay = false
+};
+/* Transport end *************************************************************/
+
+/* I2C driver begin **********************************************************/
+/*!----------------------------------------------------------------------------
+ */
+static const struct i2c_device_id mg_aI2cId[] =
+{
+   { DEVICE_BASE_FILE_NAME "-pcf8574", 0 },
+   { DEVICE_BASE_FILE_NAME "-pcf8574-wo", PCF8574_ID_WRITE_ONLY },
+   { }
+};
+MODULE_DEVICE_TABLE( i2c, mg_aI2cId );
+
+/*!----------------------------------------------------------------------------
+ * @brief Reads the optional properties of the display.
+ *
+ * The properties are the same as of the GPIO-connected displays, a
+ * display instantiated by new_device has no properties.
+ */
+static int readProperties( LCD_OBJ_T* pLcd, struct device* pDev )
+{
+   const char* pName;
+   u32 value;
+
+   pLcd->maxX = PCF8574_DEFAULT_X;
+   if( device_property_read_u32( pDev, TS(DT_TAG_X), &value ) == 0 )
+      pLcd->maxX = value;
+   pLcd->maxY = PCF8574_DEFAULT_Y;
+   if( device_property_read_u32( pDev, TS(DT_TAG_Y), &value ) == 0 )
+      pLcd->maxY = value;
+   pLcd->writeOnly |= device_property_read_bool( pDev, TS(DT_TAG_WRITE_ONLY) );
+
+   if( device_property_read_string( pDev, TS(DT_TAG_CONTROLLER), &pName ) == 0 )
+   {
+      pLcd->pTiming = findTiming( pName );
+      if( pLcd->pTiming == NULL )
+      {
+         ERROR_MESSAGE( ": Unknown controller \"%s\" in property \""
+                        TS(DT_TAG_CONTROLLER) "\"\n", pName );
+         return -EINVAL;
+      }
+   }
+   return 0;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Returns the duration of a byte on the I2C-bus in nanoseconds.
+ *
+ * The clock becomes taken from the property "clock-frequency" of the
+ * adapter, without it the fastest mode is assumed.
+ */
+static unsigned int pcf8574ByteNs( struct i2c_adapter* pAdapter )
+{
+   u32 hz = PCF8574_MAX_BUS_HZ;
+
+   if( (pAdapter->dev.parent == NULL) ||
+       (device_property_read_u32( pAdapter->dev.parent, "clock-frequency",
+                                  &hz ) != 0) || (hz == 0) )
+      hz = PCF8574_MAX_BUS_HZ;
+   return DIV_ROUND_UP( PCF8574_BITS_PER_BYTE * NSEC_PER_SEC, hz );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Creates the object and the device-file for a display on a
+ *        PCF8574.
+ *
+ * Becomes invoked for each matching node of an I2C-bus in the device-tree
+ * respectively for each device written in
+ * /sys/bus/i2c/devices/i2c-<n>/new_device.
+ */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+static int onI2cProbe( struct i2c_client* pClient )
+#else
+static int onI2cProbe( struct i2c_client* pClient,
+                       const struct i2c_device_id* pUnused )
+#endif
+{
+   const struct i2c_device_id* pId = i2c_match_id( mg_aI2cId, pClient );
+   LCD_OBJ_T* pLcd;
+   LCD_PCF8574_T* pPcf;
+   int ret;
+
+   DEBUG_MESSAGE( ": %s address 0x%02x\n", dev_name( &pClient->dev ),
+                  pClient->addr );
+
+   if( !i2c_check_functionality( pClient->adapter, I2C_FUNC_I2C ) &&
+       !i2c_check_functionality( pClient->adapter, I2C_FUNC_SMBUS_BYTE ) )
+   {
+      ERROR_MESSAGE( ": %s supports neither I2C nor SMBus byte-transfers\n",
+                     dev_name( &pClient->adapter->dev ) );
+      return -ENODEV;
+   }
+
+   pLcd = allocLcdObject();
+   if( pLcd == NULL )
+      return -ENOMEM;
+
+   if( (pId != NULL) && (pId->driver_data == PCF8574_ID_WRITE_ONLY) )
+      pLcd->writeOnly = true;
+   ret = readProperties( pLcd, &pClient->dev );
+   if( ret != 0 )
+      goto L_OBJECT_FREE;
+
+   /*
+    * The backpack connects the data-pins D4 till D7 only. The edges of
+    * the bus-signals are paced by the I2C-bus, so no CLK-delay and no
+    * calibration is necessary.
+    */
+   pLcd->port.dataCount = 4;
+   pLcd->port.dataMask  = PCF8574_DATA;
+   pLcd->clkDelayNs     = 0;
+   pLcd->pTransport     = &mg_pcf8574Transport;
+
+   pPcf = &pLcd->oPcf8574;
+   pPcf->pClient    = pClient;
+   pPcf->isPlainI2c = i2c_check_functionality( pClient->adapter, I2C_FUNC_I2C );
+   pPcf->byteNs     = pcf8574ByteNs( pClient->adapter );
+   pPcf->count      = 0;
+   /*
+    * All port-bits becomes set by the first transfer, which proves that
+    * the PCF8574 is present.
+    */
+   pPcf->port = (u8)~PCF8574_BACKLIGHT;
+   pcf8574Idle( pLcd );
+   ret = pcf8574Send( pLcd );
+   if( ret != 0 )
+   {
+      ERROR_MESSAGE( ": No PCF8574 at address 0x%02x of %s\n",
+                     pClient->addr, dev_name( &pClient->adapter->dev ) );
+      ret = -ENODEV;
+      goto L_OBJECT_FREE;
+   }
+
+   ret = registerLcdObject( pLcd, &pClient->dev );
+   if( ret != 0 )
+      goto L_OBJECT_FREE;
+
+   i2c_set_clientdata( pClient, pLcd );
+   return 0;
+
+L_OBJECT_FREE:
+   putLcdObject( pLcd );
+   return ret;
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Switches the display off and removes its object and device-file.
+ */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+static void onI2cRemove( struct i2c_client* pClient )
+#else
+static int onI2cRemove( struct i2c_client* pClient )
+#endif
+{
+   LCD_OBJ_T* pLcd = i2c_get_clientdata( pClient );
+
+   DEBUG_MESSAGE( ": " DEVICE_BASE_FILE_NAME "%d\n", pLcd->minor );
+
+   unregisterLcdObject( pLcd );
+   putLcdObject( pLcd );
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 1, 0)
+   return 0;
+#endif
+}
+
+#ifndef __NO_DEV_TREE
+/*!----------------------------------------------------------------------------
+ */
+static const struct of_device_id mg_aI2cOfMatch[] =
+{
+   { .compatible = DEVICE_BASE_FILE_NAME "-pcf8574" },
+   { }
+};
+MODULE_DEVICE_TABLE( of, mg_aI2cOfMatch );
+#endif
+
+/*!----------------------------------------------------------------------------
+ */
+static struct i2c_driver mg_i2cDriver =
+{
+   .probe    = onI2cProbe,
+   .remove   = onI2cRemove,
+   .id_table = mg_aI2cId,
+   .driver   =
+   {
+      .name = DEVICE_BASE_FILE_NAME "-pcf8574",
+   #ifndef __NO_DEV_TREE
+      .of_match_table = mg_aI2cOfMatch,
+   #endif
+   }
+};
+
+/*!----------------------------------------------------------------------------
+ */
+int pcf8574DriverRegister( void )
+{
+   return i2c_add_driver( &mg_i2cDriver );
+}
+
+/*!----------------------------------------------------------------------------
+ * @brief Invokes onI2cRemove() for each display on a PCF8574.
+ */
+void pcf8574DriverUnregister( void )
+{
+   i2c_del_driver( &mg_i2cDriver );
+}
+/* I2C driver end ************************************************************/
+
+#endif /* ifdef CONFIG_AN_LCD_PCF8574 */
+/*================================== EOF ====================================*/
@@ -0,0 +1,40 @@
+/*****************************************************************************/
+/*                                                                           */
+/*!   @brief HD44780 compatible displays connected via PCF8574 backpack      */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+/*! @file    anLcd_pcf8574.h                                                 */
+/*! @see     anLcd_pcf8574.c                                                 */
+/*! @see     anLcd_drv.c                                                     */
+/*! @author  Ulrich Becker                                                   */
+/*! @date    17.10.2026                                                      */
+/*****************************************************************************/
+#ifndef _ANLCD_PCF8574_H
+#define _ANLCD_PCF8574_H
+
+#include "anLcd_drv.h"
+
+#if defined( CONFIG_AN_LCD_PCF8574 ) || defined(__DOXYGEN__)
+/*!
+ * @defgroup PCF8574_PORT Wiring of the common backpacks
+ * @{
+ */
+#define PCF8574_RS        0x01 /*!<@brief P0 */
+#define PCF8574_RW        0x02 /*!<@brief P1 */
+#define PCF8574_EN        0x04 /*!<@brief P2 */
+#define PCF8574_BACKLIGHT 0x08 /*!<@brief P3, switches the backlight on */
+#define PCF8574_DATA      0xF0 /*!<@brief P4 till P7 on D4 till D7 */
+/*! @} */
+
+int pcf8574DriverRegister( void );
+void pcf8574DriverUnregister( void );
+
+#else
+
+static inline int pcf8574DriverRegister( void ) { return 0; }
+static inline void pcf8574DriverUnregister( void ) {}
+
+#endif /* else if defined( CONFIG_AN_LCD_PCF8574 ) || defined(__DOXYGEN__) */
+
+#endif /* ifndef _ANLCD_PCF8574_H */
+/*================================== EOF ====================================*/
@@ -0,0 +1,195 @@
+/*****************************************************************************/
+/*                                                                           */
+/*!   @brief Tracepoints of the driver for HD44780 compatible displays       */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+/*! @file    anLcd_trace.h                                                   */
+/*! @see     anLcd_drv.c                                                     */
+/*! @see     hd44780Display.c                                                */
+/*! @author  Ulrich Becker                                                   */
+/*! @date    17.10.2026                                                      */
+/*****************************************************************************/
+/*
+ * The tracepoints are cost-free as long as they are not enabled, that means
+ * a no-operation which becomes patched by a static-key.
+ * Usage e.g.:
+ *    trace-cmd record -e anLcd
+ *    perf trace -e 'anLcd:*'
+ * or:
+ *    echo 1 > /sys/kernel/tracing/events/anLcd/enable
+ *    cat /sys/kernel/tracing/trace_pipe
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM anLcd
+
+#if !defined( _ANLCD_TRACE_H ) || defined( TRACE_HEADER_MULTI_READ )
+#define _ANLCD_TRACE_H
+
+#include <linux/tracepoint.h>
+#include "hd44780Display.h"
+
+/*!
+ * @brief Identifiers of the work-items for the events anLcd_work_begin
+ *        and anLcd_work_end.
+ */
+#define ANLCD_TRACE_WORK_INIT  0
+#define ANLCD_TRACE_WORK_WRITE 1
+
+/*!
+ * @brief Byte transferred to the display-controller by lcdSetData(),
+ *        including the polling of the busy-flag.
+ */
+TRACE_EVENT( anLcd_set_data,
+   TP_PROTO( int minor, u8 data, int addr, unsigned int polls, u64 ns ),
+   TP_ARGS( minor, data, addr, polls, ns ),
+   TP_STRUCT__entry(
+      __field( int,          minor )
+      __field( u8,           data  )
+      __field( int,          addr  )
+      __field( unsigned int, polls )
+      __field( u64,          ns    )
+   ),
+   TP_fast_assign(
+      __entry->minor = minor;
+      __entry->data  = data;
+      __entry->addr  = addr;
+      __entry->polls = polls;
+      __entry->ns    = ns;
+   ),
+   TP_printk( "lcd%d data=%02x addr=%02x polls=%u ns=%llu",
+              __entry->minor, __entry->data, __entry->addr,
+              __entry->polls, __entry->ns )
+);
+
+/*!
+ * @brief The busy-flag was still set after CONFIG_TLCD_MAX_POLL polls.
+ */
+TRACE_EVENT( anLcd_poll_timeout,
+   TP_PROTO( int minor, u8 data ),
+   TP_ARGS( minor, data ),
+   TP_STRUCT__entry(
+      __field( int, minor )
+      __field( u8,  data  )
+   ),
+   TP_fast_assign(
+      __entry->minor = minor;
+      __entry->data  = data;
+   ),
+   TP_printk( "lcd%d data=%02x", __entry->minor, __entry->data )
+);
+
+/*!
+ * @brief Set-address command of the DD-RAM, ret is the address read back
+ *        from the controller.
+ */
+TRACE_EVENT( anLcd_set_address,
+   TP_PROTO( int minor, int addr, int ret, u64 ns ),
+   TP_ARGS( minor, addr, ret, ns ),
+   TP_STRUCT__entry(
+      __field( int, minor )
+      __field( int, addr  )
+      __field( int, ret   )
+      __field( u64, ns    )
+   ),
+   TP_fast_assign(
+      __entry->minor = minor;
+      __entry->addr  = addr;
+      __entry->ret   = ret;
+      __entry->ns    = ns;
+   ),
+   TP_printk( "lcd%d addr=%02x ret=%02x ns=%llu",
+              __entry->minor, __entry->addr, __entry->ret, __entry->ns )
+);
+
+/*
+ * The values of LCD_STATUS_T becomes exported to the format-file, so
+ * user-space tools like trace-cmd and perf resolve the names as well.
+ */
+TRACE_DEFINE_ENUM( LCD_NORMAL );
+TRACE_DEFINE_ENUM( LCD_UMLAUT );
+TRACE_DEFINE_ENUM( LCD_SPECIAL_CHAR );
+TRACE_DEFINE_ENUM( LCD_ESC );
+TRACE_DEFINE_ENUM( LCD_CTRL );
+TRACE_DEFINE_ENUM( LCD_CURSOR );
+
+#define ANLCD_TRACE_SHOW_STATE( state )                                 \
+   __print_symbolic( state,                                             \
+                     { LCD_NORMAL,       "NORMAL"       },              \
+                     { LCD_UMLAUT,       "UMLAUT"       },              \
+                     { LCD_SPECIAL_CHAR, "SPECIAL_CHAR" },              \
+                     { LCD_ESC,          "ESC"          },              \
+                     { LCD_CTRL,         "CTRL"         },              \
+                     { LCD_CURSOR,       "CURSOR"       } )
+
+/*!
+ * @brief State-transition of the escape- and UTF-8-parser of lcdPutch(),
+ *        see LCD_STATUS_T.
+ */
+TRACE_EVENT( anLcd_putch_state,
+   TP_PROTO( int minor, int oldState, int newState ),
+   TP_ARGS( minor, oldState, newState ),
+   TP_STRUCT__entry(
+      __field( int, minor    )
+      __field( int, oldState )
+      __field( int, newState )
+   ),
+   TP_fast_assign(
+      __entry->minor    = minor;
+      __entry->oldState = oldState;
+      __entry->newState = newState;
+   ),
+   TP_printk( "lcd%d %s -> %s", __entry->minor,
+              ANLCD_TRACE_SHOW_STATE( __entry->oldState ),
+              ANLCD_TRACE_SHOW_STATE( __entry->newState ) )
+);
+
+/*!
+ * @brief Begin and end of the work-items onWorkqueueInit() and
+ *        onWorkqueueWrite().
+ *
+ * For the end-event bytes is the number of written characters contained
+ * in the flushed screen-model and ns the duration of the work-item, resp.
+ * 0 if the event became enabled while the work-item was running.
+ */
+DECLARE_EVENT_CLASS( anLcd_work,
+   TP_PROTO( int minor, int work, unsigned int bytes, u64 ns ),
+   TP_ARGS( minor, work, bytes, ns ),
+   TP_STRUCT__entry(
+      __field( int,          minor )
+      __field( int,          work  )
+      __field( unsigned int, bytes )
+      __field( u64,          ns    )
+   ),
+   TP_fast_assign(
+      __entry->minor = minor;
+      __entry->work  = work;
+      __entry->bytes = bytes;
+      __entry->ns    = ns;
+   ),
+   TP_printk( "lcd%d %s bytes=%u ns=%llu", __entry->minor,
+              __print_symbolic( __entry->work,
+                                { ANLCD_TRACE_WORK_INIT,  "init"  },
+                                { ANLCD_TRACE_WORK_WRITE, "write" } ),
+              __entry->bytes, __entry->ns )
+);
+
+DEFINE_EVENT( anLcd_work, anLcd_work_begin,
+   TP_PROTO( int minor, int work, unsigned int bytes, u64 ns ),
+   TP_ARGS( minor, work, bytes, ns )
+);
+
+DEFINE_EVENT( anLcd_work, anLcd_work_end,
+   TP_PROTO( int minor, int work, unsigned int bytes, u64 ns ),
+   TP_ARGS( minor, work, bytes, ns )
+);
+
+#endif /* if !defined( _ANLCD_TRACE_H ) || defined( TRACE_HEADER_MULTI_READ ) */
+
+/* This part must be outside of the include-guard. */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE anLcd_trace
+#include <trace/define_trace.h>
+
+/*================================== EOF ====================================*/
@@ -30,10 +30,14 @@
   #include <util/delay.h>
   #include <utermctrl.h>
   #include <u_assert.h>
+  #include <string.h>
 #endif
 #include "hd44780Display.h"
+#ifdef __KERNEL__
+  #include "anLcd_trace.h"
+#endif
 
-#ifndef CONFIG_TLCD_CLK_DELAY
+#if !defined( CONFIG_TLCD_CLK_DELAY ) && !defined(__KERNEL__)
   #define CONFIG_TLCD_CLK_DELAY 50 //!<@brief CLK-delay in microseconds.
 #endif
 
@@ -67,10 +71,16 @@
 #ifdef __KERNEL__
   #ifdef _LCD_DATAPORT_PINS_8
     #error Macro _LCD_DATAPORT_PINS_8 is defined for Linux-kernel \
-           but it sopported 4-bit mode only!
+           but the bus-width becomes selected at probe-time!
   #endif
-  #define LCD_DATA_MASK 0x0F
-  #define LCD_PORT_SHIFT 0
+  /*
+   * writeLcdPort() and readLcdPort() of the kernel-driver are transferring
+   * the byte in the bit-positions of the data-pins D0 till D7, in 4-bit mode
+   * the nibble is transferred by D4 till D7.
+   */
+  #define LCD_DATA_MASK 0xF0
+  #define LCD_PORT_SHIFT 4
+  #define LCD_IS_DATAPORT_8() (pLcd->port.dataCount == 8)
 #else
   #ifndef _LCD_DATAPORT_PINS_8
    #if LCD_DATA_MASK == 0x0F
@@ -91,21 +101,150 @@
      #undef LCD_DATA_MASK
    #endif
    #define LCD_DATA_MASK 0xFF
+   #define LCD_PORT_SHIFT 0
+  #endif
+  #ifdef _LCD_DATAPORT_PINS_8
+    #define LCD_IS_DATAPORT_8() TRUE
+  #else
+    #define LCD_IS_DATAPORT_8() FALSE
   #endif
 #endif
 
+/*!
+ * @brief Execution times of the display-controller in microseconds
+ *        (datasheet HD44780, f_osc = 270 kHz).
+ *
+ * Used in the write-only mode (RW tied low) instead of polling the busy-flag.
+ * The kernel-driver takes these times from the controller-profile of the
+ * display, see LCD_TIMING_T.
+ */
+#define LCD_EXEC_TIME_US 37   /*!<@brief All instructions and data-writes */
+#define LCD_HOME_TIME_US 1520 /*!<@brief Clear display and return home */
+
+/*!
+ * @brief True for the instructions clear display (0x01) and return home
+ *        (0x02, 0x03), which are taking LCD_HOME_TIME_US.
+ */
+#define LCD_IS_HOME_INSTRUCTION( d ) (((d) & 0xFC) == 0)
+
 #ifdef __KERNEL__
-  #define LCD_SET_EN_LOW()         gpio_direction_output( global.oLcd.port.en.number, 0 )
-  #define LCD_SET_EN_HIGH()        gpio_direction_input( global.oLcd.port.en.number )
-  #define LCD_SET_HIGH_IMPEDANCE() writeLcdPort( 0xFF );
-  #define LCD_SELECT_INSTRUCTION() gpio_direction_output( global.oLcd.port.rs.number, 0 )
-  #define LCD_SELECT_DATA()        gpio_direction_input( global.oLcd.port.rs.number )
-  #define LCD_MODE_READ()          gpio_direction_input( global.oLcd.port.rw.number )
-  #define LCD_MODE_WRITE()         gpio_direction_output( global.oLcd.port.rw.number, 0 )
-  #define LCD_INIT_WAIT()          mdelay( 200 )
-  #define LCD_CLK_WAIT()           udelay( CONFIG_TLCD_CLK_DELAY )
-  #define LCD_POLL_FUNCTION()      schedule()
-  #define LCD_ERROR_HANDLING()     global.oLcd.isInitialized = false
+  #define LCD_SET_CONTROL_PIN( pin, mask, value )                        \
+     do                                                                  \
+     {                                                                   \
+        setLcdPin( &pLcd->port.pin, value );                             \
+        LCD_CAPTURE( pLcd, mask, (value)? (mask) : 0 );                  \
+     }                                                                   \
+     while( false )
+  #define LCD_SET_EN_LOW()         LCD_SET_CONTROL_PIN( en, LCD_CAPTURE_EN, 0 )
+  #define LCD_SET_EN_HIGH()        LCD_SET_CONTROL_PIN( en, LCD_CAPTURE_EN, 1 )
+  #define LCD_SET_HIGH_IMPEDANCE() releaseLcdPort( pLcd );
+  #define LCD_SET_RS( value )      LCD_SET_CONTROL_PIN( rs, LCD_CAPTURE_RS, value )
+  /*
+   * The level of rs becomes passed to the operations of the transport,
+   * see LCD_TRANSPORT_T.
+   */
+  #define LCD_SELECT_INSTRUCTION() pLcd->port.isData = false
+  #define LCD_SELECT_DATA()        pLcd->port.isData = true
+  #define LCD_IS_WRITE_ONLY()      pLcd->writeOnly
+  #define LCD_MODE_READ()                                                \
+     do                                                                  \
+     {                                                                   \
+        if( !LCD_IS_WRITE_ONLY() )                                       \
+           LCD_SET_CONTROL_PIN( rw, LCD_CAPTURE_RW, 1 );                 \
+     }                                                                   \
+     while( false )
+  #define LCD_MODE_WRITE()                                               \
+     do                                                                  \
+     {                                                                   \
+        if( !LCD_IS_WRITE_ONLY() )                                       \
+           LCD_SET_CONTROL_PIN( rw, LCD_CAPTURE_RW, 0 );                 \
+     }                                                                   \
+     while( false )
+  #define LCD_STATISTIC_INC( c )   pLcd->oStatistic.c++
+  /*
+   * The edges of the bus-signals of the bit-banging are timed by
+   * LCD_NDELAY(), the waits for the display-controller by the transport,
+   * so e.g. a PCF8574 can send its collected port-bytes before.
+   */
+  #define LCD_NDELAY( ns )         lcdDelayNs( pLcd, ns )
+  #define LCD_WAIT( ns )           pLcd->pTransport->delay( pLcd, ns )
+  #define LCD_INIT_WAIT()                                                \
+     LCD_WAIT( pLcd->pTiming->initMs * NSEC_PER_MSEC )
+  /*
+   * Execution times of the command-classes of the controller-profile,
+   * see LCD_TIMING_T.
+   */
+  #define LCD_EXEC_WAIT()                                                \
+     LCD_WAIT( pLcd->port.isData? pLcd->pTiming->dataNs :                \
+                                  pLcd->pTiming->commandNs )
+  #define LCD_HOME_WAIT()          LCD_WAIT( pLcd->pTiming->clearNs )
+  /*
+   * The bus-timing is the maximum of the datasheet-values of the
+   * controller-profile and the CLK-delay of the wiring, which becomes
+   * calibrated at initialization or given by device-tree resp. sysfs.
+   */
+  #define LCD_SETUP_WAIT()                                               \
+     LCD_NDELAY( max( pLcd->clkDelayNs, pLcd->pTiming->setupNs ) )
+  #define LCD_CLK_WAIT()                                                 \
+     LCD_NDELAY( max( pLcd->clkDelayNs, pLcd->pTiming->pulseNs ) )
+  /*
+   * The known execution time of the instruction resp. data-write becomes
+   * slept before polling the busy-flag, so the first poll succeeds
+   * normally instead of spinning over the bus.
+   */
+  #define LCD_BUSY_SLEEP( d )                                            \
+     do                                                                  \
+     {                                                                   \
+        if( !pLcd->port.isData && LCD_IS_HOME_INSTRUCTION( d ) )         \
+           LCD_HOME_WAIT();                                              \
+        else                                                             \
+           LCD_EXEC_WAIT();                                              \
+     }                                                                   \
+     while( false )
+  /*
+   * A still set busy-flag becomes polled again after sleeping the
+   * execution time of an instruction.
+   */
+  #define LCD_POLL_FUNCTION()      LCD_WAIT( pLcd->pTiming->commandNs )
+  #define LCD_ERROR_HANDLING()     pLcd->isInitialized = false
+  /*
+   * Tracepoints, the arguments becomes evaluated only if the event is
+   * enabled, otherwise it costs a no-operation patched by a static-key.
+   */
+  #define LCD_TRACE_TIME_DECL( t ) u64 t = 0
+  #define LCD_TRACE_START( event, t )                                     \
+     do                                                                  \
+     {                                                                   \
+        if( trace_ ## event ## _enabled() )                              \
+           t = ktime_get_ns();                                           \
+     }                                                                   \
+     while( false )
+  /*
+   * An event enabled between start and end has no start-time, so its
+   * elapsed time becomes 0 instead of the time since booting.
+   */
+  #define LCD_TRACE_ELAPSED( t )   (((t) != 0)? ktime_get_ns() - (t) : 0)
+  #define LCD_TRACE( event, args... )                                     \
+     do                                                                  \
+     {                                                                   \
+        if( trace_ ## event ## _enabled() )                              \
+           trace_ ## event( pLcd->minor, ## args );                      \
+     }                                                                   \
+     while( false )
+  /*
+   * Time of each byte on the bus for the histogram in the debug-file-system
+   * respectively for the tracepoint anLcd_set_data.
+   */
+  #ifdef CONFIG_DEBUG_FS
+    #define LCD_BUS_TIME_DECL( t ) u64 t = ktime_get_ns()
+    #define LCD_BUS_TIME_ADD( t )                                        \
+       lcdLatencyAdd( pLcd, &pLcd->oLatency.bus, LCD_TRACE_ELAPSED( t ) )
+  #else
+    #define LCD_BUS_TIME_DECL( t )                                       \
+       LCD_TRACE_TIME_DECL( t );                                         \
+       LCD_TRACE_START( anLcd_set_data, t )
+    #define LCD_BUS_TIME_ADD( t )
+  #endif
 #else /* AVR */
   #define LCD_SET_EN_LOW()         LCD_CONTROL_PORT &= ~LCD_EN_MASK
   #define LCD_SET_EN_HIGH()        LCD_CONTROL_PORT |= LCD_EN_MASK
@@ -119,15 +258,34 @@
   #define LCD_SELECT_INSTRUCTION() LCD_CONTROL_PORT &= ~LCD_RS_MASK
   #define LCD_SELECT_DATA()        LCD_CONTROL_PORT |= LCD_RS_MASK
 
-  #define LCD_MODE_READ()          LCD_CONTROL_PORT |= LCD_RW_MASK
-  #define LCD_MODE_WRITE()         LCD_CONTROL_PORT &= ~LCD_RW_MASK
+  #ifdef _LCD_WRITE_ONLY
+    #define LCD_IS_WRITE_ONLY()    TRUE
+    #define LCD_MODE_READ()
+    #define LCD_MODE_WRITE()
+  #else
+    #define LCD_IS_WRITE_ONLY()    FALSE
+    #define LCD_MODE_READ()        LCD_CONTROL_PORT |= LCD_RW_MASK
+    #define LCD_MODE_WRITE()       LCD_CONTROL_PORT &= ~LCD_RW_MASK
+  #endif
 
   #ifndef LCD_CLK_WAIT
     #define LCD_CLK_WAIT()  _delay_us( 30.0 )
   #endif
+  #ifndef LCD_SETUP_WAIT
+    #define LCD_SETUP_WAIT() LCD_CLK_WAIT()
+  #endif
   #ifndef LCD_INIT_WAIT
     #define LCD_INIT_WAIT() _delay_ms( 200.0 )
   #endif
+  #ifndef LCD_EXEC_WAIT
+    #define LCD_EXEC_WAIT() _delay_us( LCD_EXEC_TIME_US )
+  #endif
+  #ifndef LCD_HOME_WAIT
+    #define LCD_HOME_WAIT() _delay_us( LCD_HOME_TIME_US )
+  #endif
+  #ifndef LCD_BUSY_SLEEP
+     #define LCD_BUSY_SLEEP( d )
+  #endif
   #ifndef LCD_POLL_FUNCTION
      #define LCD_POLL_FUNCTION()
   #endif
@@ -140,6 +298,12 @@
   #ifndef DEBUG_MESSAGE
     #define DEBUG_MESSAGE()
   #endif
+  #define LCD_TRACE_TIME_DECL( t )
+  #define LCD_TRACE_START( event, t )
+  #define LCD_TRACE( event, args... )
+  #define LCD_BUS_TIME_DECL( t )
+  #define LCD_BUS_TIME_ADD( t )
+  #define LCD_STATISTIC_INC( c )
 #endif /* else of ifdef __KERNEL__ */
 
 
@@ -155,7 +319,7 @@
  #else
    #error LCD_MAX_Y is invalid!
  #endif
- #define readLcdPort()     LCD_DATA_PIN
+ #define readLcdPort( o )  LCD_DATA_PIN
  #define writeLcdPort( b ) LCD_DATA_DDR |= (b)
 #endif
 
@@ -189,8 +353,8 @@
 
 #ifndef _LCD_MINIMAL
 #ifdef __KERNEL__
- #define mg_lcdAutoScroll global.oLcd.autoScroll
- #define mg_lastChar      global.oLcd.lastChar
+ #define mg_lcdAutoScroll pLcd->autoScroll
+ #define mg_lastChar      pLcd->lastChar
 #else
  BOOL mg_lcdAutoScroll;
  static BOOL mg_lastChar;
@@ -308,16 +472,17 @@ CHAR_MAP_T FLASH mg_specialCharMap[] =
    { 0, 0 } // Please don't forget this terminator!
 };
 
-typedef enum
-{
-   LCD_NORMAL,
-   LCD_UMLAUT,
-   LCD_SPECIAL_CHAR,
-   LCD_ESC,
-   LCD_CTRL,
-   LCD_CURSOR
-} LCD_STATUS_T;
-LCD_STATUS_T mg_putchState;
+#ifdef __KERNEL__
+ #define mg_putchState   pLcd->putchState
+ #define mg_escParameter pLcd->escParameter
+ #define mg_escIndex     pLcd->escIndex
+#else
+ LCD_STATUS_T mg_putchState;
+ #ifndef CONFIG_LCD_NO_TERMINAL
+  static TERMINAL_T  mg_escParameter[2];
+  static LCD_INDEX_T mg_escIndex = 0;
+ #endif
+#endif
 
 #if defined(__KERNEL__) && defined( CONFIG_DEBUG_TLCD_FSM )
 /*!---------------------------------------------------------------------------
@@ -332,6 +497,7 @@ static const char* getStateStr( LCD_STATUS_T state )
    {
       ST_ENUM_CASE_ITEM( LCD_NORMAL );
       ST_ENUM_CASE_ITEM( LCD_UMLAUT );
+      ST_ENUM_CASE_ITEM( LCD_SPECIAL_CHAR );
       ST_ENUM_CASE_ITEM( LCD_ESC );
       ST_ENUM_CASE_ITEM( LCD_CTRL );
       ST_ENUM_CASE_ITEM( LCD_CURSOR );
@@ -341,11 +507,21 @@ static const char* getStateStr( LCD_STATUS_T state )
    return "undefined";
 }
 
+  #define FSM_DEBUG_MESSAGE( newState ) \
+     DEBUG_MESSAGE( ": Set state %s -> %s\n", getStateStr( mg_putchState ), #newState )
+#else
+  #define FSM_DEBUG_MESSAGE( newState )
+#endif
+
+#ifdef __KERNEL__
   #define TRANSITION( newState ) \
   do \
   { \
      if( mg_putchState != newState ) \
-        DEBUG_MESSAGE( ": Set state %s -> %s\n", getStateStr( mg_putchState ), #newState ); \
+     { \
+        FSM_DEBUG_MESSAGE( newState ); \
+        LCD_TRACE( anLcd_putch_state, mg_putchState, newState ); \
+     } \
      mg_putchState = newState; \
   } \
   while( false )
@@ -357,114 +533,335 @@ static const char* getStateStr( LCD_STATUS_T state )
 #endif /* ifndef _LCD_MINIMAL */
 
 #ifdef __KERNEL__
- #define mg_displayState global.oLcd.displayState
+ #define mg_displayState pLcd->displayState
 #else
  BYTE mg_displayState;
 #endif
 
+#ifdef _LCD_SHADOW_RAM
+#ifdef __KERNEL__
+ #define mg_shadow pLcd->oShadow
+#else
+ static LCD_SHADOW_T mg_shadow;
+#endif
+ /*
+  * The RAM-copy contains the address-counter already.
+  */
+ #define mg_ac mg_shadow
+#else
+/*!
+ * @brief Imitation of the address-counter of the display-controller.
+ */
+typedef struct
+{
+   LCD_ADDR_T addr;    //!< @brief Current DD- or CG-RAM address.
+   BOOL       isCgRam; //!< @brief TRUE when addr refers to the CG-RAM.
+} LCD_AC_T;
+
+static LCD_AC_T mg_ac;
+#endif /* else ifdef _LCD_SHADOW_RAM */
+
+/*!
+ * @brief Number of DD-RAM cells per line of the display-controller
+ *        in 2-line mode.
+ */
+#define LCD_MEM_LINE_LEN 40
+
+/*--------------------------- lcdDdRamNextAddr --------------------------------
+ * Imitates the auto-increment of the DD-RAM address-counter of the controller.
+ */
+static LCD_ADDR_T lcdDdRamNextAddr( LCD_OBJ_DECL_ LCD_ADDR_T addr )
+{
+   if( MAX_Y() == 1 )
+      return (addr >= (2 * LCD_MEM_LINE_LEN - 1))? 0 : (addr + 1);
+   if( addr == (LCD_MEM_LINE_LEN - 1) )
+      return LCD_MEM_LINE_SIZE;
+   if( addr >= (LCD_MEM_LINE_SIZE + LCD_MEM_LINE_LEN - 1) )
+      return 0;
+   return addr + 1;
+}
+
+/*----------------------------- lcdAcNextAddr ---------------------------------
+*/
+static LCD_ADDR_T lcdAcNextAddr( LCD_OBJ_DECL_ LCD_ADDR_T addr )
+{
+   if( mg_ac.isCgRam )
+      return (addr + 1) & (LCD_CGRAM_CHARS * sizeof( LCD_CGRAM_CHAR_T ) - 1);
+   return lcdDdRamNextAddr( LCD_OBJ_ addr );
+}
+
+/*---------------------------- lcdAcSetAddress --------------------------------
+*/
+static INLINE void lcdAcSetAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr, BOOL isCgRam )
+{
+   mg_ac.addr = addr;
+   mg_ac.isCgRam = isCgRam;
+}
+
+/*------------------------------- lcdAcNext -----------------------------------
+ * Follows the auto-increment of the controller after each read or written
+ * data-byte, so the current address is known without reading it back.
+ */
+static INLINE void lcdAcNext( LCD_OBJ_DECL )
+{
+   mg_ac.addr = lcdAcNextAddr( LCD_OBJ_ mg_ac.addr );
+}
+
+#ifdef _LCD_SHADOW_RAM
+/*----------------------------- lcdShadowStore --------------------------------
+*/
+static void lcdShadowStore( LCD_OBJ_DECL_ BYTE d )
+{
+   if( mg_shadow.isCgRam )
+      ((BYTE*)mg_shadow.cgRam)[mg_shadow.addr] = d;
+   else
+      mg_shadow.ddRam[mg_shadow.addr & (LCD_DDRAM_SIZE - 1)] = d;
+}
+
+/*----------------------------- lcdShadowClear --------------------------------
+*/
+static void lcdShadowClear( LCD_OBJ_DECL )
+{
+   memset( mg_shadow.ddRam, ' ', sizeof( mg_shadow.ddRam ) );
+}
+
+#else
+ #define lcdShadowStore( d )
+ #define lcdShadowClear( o )
+#endif /* ifdef _LCD_SHADOW_RAM */
+
+#ifdef _LCD_SCREEN_MODEL
+#ifdef __KERNEL__
+ #define mg_screen pLcd->oScreen
+ /*
+  * The driver takes a snapshot of the screen-model for lcdFlush(), so the
+  * model can be changed while the flush is running.
+  */
+ #define mg_frame             pLcd->oFrame
+ #define mg_frameDisplayState pLcd->frameDisplayState
+#else
+ static LCD_SCREEN_T mg_screen;
+ #define mg_frame             mg_screen
+ #define mg_frameDisplayState mg_displayState
+#endif
+
+/*----------------------------- lcdScreenClear --------------------------------
+*/
+static void lcdScreenClear( LCD_OBJ_DECL )
+{
+   memset( mg_screen.ddRam, ' ', sizeof( mg_screen.ddRam ) );
+   mg_screen.addr = 0;
+}
+#endif /* ifdef _LCD_SCREEN_MODEL */
+
 /*----------------------------- _lcdSetData -----------------------------------
 */
-static void _lcdSetData( BYTE d )
+static void _lcdSetData( LCD_OBJ_DECL_ BYTE d )
 {
    LCD_MODE_WRITE();
-   LCD_CLK_WAIT();
+   LCD_SETUP_WAIT();
 #if !defined(_LCD_DDR_INVERS ) && !defined(__KERNEL__)
    d = ~d;
 #endif
    LCD_SET_EN_HIGH();
    LCD_CLK_WAIT();
-#ifdef _LCD_DATAPORT_PINS_8
-   writeLcdPort( d );
-#else
-   //!!LCD_SET_HIGH_IMPEDANCE();
-   writeLcdPort( ((d << LCD_PORT_SHIFT) & LCD_DATA_MASK ) );
-#endif
+   if( LCD_IS_DATAPORT_8() )
+      writeLcdPort( LCD_OBJ_ d );
+   else
+   {
+      //!!LCD_SET_HIGH_IMPEDANCE();
+      writeLcdPort( LCD_OBJ_ ((d << LCD_PORT_SHIFT) & LCD_DATA_MASK ) );
+   }
    LCD_CLK_WAIT();
    LCD_SET_EN_LOW();
 }
 
 /*---------------------------- lcdGetData -------------------------------------
 */
-static BYTE lcdGetData( void )
+static BYTE lcdGetData( LCD_OBJ_DECL )
 {
    BYTE data;
 
    LCD_SET_HIGH_IMPEDANCE(); 
    LCD_MODE_READ();
-   LCD_CLK_WAIT();
+   LCD_SETUP_WAIT();
    LCD_SET_EN_HIGH();
    LCD_CLK_WAIT();
-#ifdef _LCD_DATAPORT_PINS_8
-   data = readLcdPort();
-#else
-   data = ((readLcdPort() & LCD_DATA_MASK) >> LCD_PORT_SHIFT) << 4;
-   LCD_SET_EN_LOW();
-   LCD_CLK_WAIT();
-   LCD_SET_EN_HIGH();
-   LCD_CLK_WAIT();
-   data |= (readLcdPort() & LCD_DATA_MASK) >> LCD_PORT_SHIFT;
-#endif
+   if( LCD_IS_DATAPORT_8() )
+      data = readLcdPort( LCD_OBJ );
+   else
+   {
+      data = ((readLcdPort( LCD_OBJ ) & LCD_DATA_MASK) >> LCD_PORT_SHIFT) << 4;
+      LCD_SET_EN_LOW();
+      LCD_SETUP_WAIT();
+      LCD_SET_EN_HIGH();
+      LCD_CLK_WAIT();
+      data |= (readLcdPort( LCD_OBJ ) & LCD_DATA_MASK) >> LCD_PORT_SHIFT;
+   }
    LCD_SET_EN_LOW();
    return data;
 }
 
-#if (LCD_MAX_Y > 1) || defined(__KERNEL__)
-/*------------------------------ lcdGetChar -----------------------------------
+/*----------------------------- lcdWriteByte ----------------------------------
 */
-char lcdGetChar( void )
+static void lcdWriteByte( LCD_OBJ_DECL_ BYTE d )
 {
-   LCD_SELECT_DATA();
-   return lcdGetData();
+   LCD_MODE_WRITE();
+   if( !LCD_IS_DATAPORT_8() )
+      _lcdSetData( LCD_OBJ_ d >> 4 ); // High
+   _lcdSetData( LCD_OBJ_ d );         // Low
+}
+
+#ifdef __KERNEL__
+/*---------------------------- lcdBitBangIdle ---------------------------------
+ * The functions lcdBitBang... are the operations of the transport of
+ * GPIO-connected displays, see LCD_TRANSPORT_T.
+ */
+void lcdBitBangIdle( LCD_OBJ_T* pLcd )
+{
+   LCD_SET_HIGH_IMPEDANCE();
+   LCD_SET_RS( 1 );
+   LCD_MODE_READ();
+   LCD_SET_EN_HIGH();
+}
+
+/*------------------------- lcdBitBangWriteNibble -----------------------------
+*/
+void lcdBitBangWriteNibble( LCD_OBJ_T* pLcd, bool isData, u8 data )
+{
+   LCD_SET_RS( isData );
+   _lcdSetData( pLcd, data );
+}
+
+/*-------------------------- lcdBitBangWriteByte ------------------------------
+*/
+void lcdBitBangWriteByte( LCD_OBJ_T* pLcd, bool isData, u8 data )
+{
+   LCD_SET_RS( isData );
+   lcdWriteByte( pLcd, data );
+}
+
+/*-------------------------- lcdBitBangReadByte -------------------------------
+*/
+u8 lcdBitBangReadByte( LCD_OBJ_T* pLcd, bool isData )
+{
+   LCD_SET_RS( isData );
+   return lcdGetData( pLcd );
+}
+
+  #define LCD_BUS_IDLE()           pLcd->pTransport->idle( pLcd )
+  #define LCD_WRITE_NIBBLE( d )                                          \
+     pLcd->pTransport->writeNibble( pLcd, pLcd->port.isData, d )
+  #define LCD_WRITE_BYTE( d )                                            \
+     pLcd->pTransport->writeByte( pLcd, pLcd->port.isData, d )
+  #define LCD_READ_BYTE()                                                \
+     pLcd->pTransport->readByte( pLcd, pLcd->port.isData )
+#else
+  #define LCD_BUS_IDLE()                                                 \
+     do                                                                  \
+     {                                                                   \
+        LCD_SET_HIGH_IMPEDANCE();                                        \
+        LCD_SELECT_DATA();                                               \
+        LCD_MODE_READ();                                                 \
+        LCD_SET_EN_HIGH();                                               \
+     }                                                                   \
+     while( FALSE )
+  #define LCD_WRITE_NIBBLE( d )    _lcdSetData( d )
+  #define LCD_WRITE_BYTE( d )      lcdWriteByte( d )
+  #define LCD_READ_BYTE()          lcdGetData()
+#endif /* else ifdef __KERNEL__ */
+
+#if (LCD_MAX_Y > 1) || defined(__KERNEL__) || defined(_LCD_SCREEN_MODEL)
+/*------------------------------ _lcdGetChar ----------------------------------
+*/
+static char _lcdGetChar( LCD_OBJ_DECL )
+{
+   char c;
+
+#ifdef _LCD_SHADOW_RAM
+   if( LCD_IS_WRITE_ONLY() )
+      c = mg_shadow.ddRam[mg_shadow.addr & (LCD_DDRAM_SIZE - 1)];
+   else
+#endif
+   {
+      LCD_SELECT_DATA();
+      c = LCD_READ_BYTE();
+   }
+   lcdAcNext( LCD_OBJ );
+   return c;
 }
 #endif
 
 /*------------------------------ lcdIsBusy ------------------------------------
 */
-BOOL lcdIsBusy( LCD_ADDR_T* pAddr )
+BOOL lcdIsBusy( LCD_OBJ_DECL_ LCD_ADDR_T* pAddr )
 {
+   if( LCD_IS_WRITE_ONLY() )
+   { /*
+      * Busy-flag is not readable, the address-counter becomes
+      * imitated in RAM.
+      */
+      *pAddr = mg_ac.addr;
+      return FALSE;
+   }
+   LCD_STATISTIC_INC( busyReads );
    LCD_SELECT_INSTRUCTION(); // RS = 0
-   LCD_SET_HIGH_IMPEDANCE()
-   LCD_CLK_WAIT();
-   *pAddr = lcdGetData();
+   *pAddr = LCD_READ_BYTE();
    return (*pAddr & 0x80) != 0;
 }
 
 /*----------------------------- lcdSetData ------------------------------------
 */
-static LCD_ADDR_T lcdSetData( BYTE d )
+static LCD_ADDR_T lcdSetData( LCD_OBJ_DECL_ BYTE d )
 {
    LCD_ADDR_T addr;
    LCD_POLL_T poll = CONFIG_TLCD_MAX_POLL;
+   LCD_BUS_TIME_DECL( t );
 
-   LCD_MODE_WRITE();
- #ifndef _LCD_DATAPORT_PINS_8
-   _lcdSetData( d >> 4 ); // High
- #endif
-   _lcdSetData( d );      // Low
-   while( lcdIsBusy( &addr ) )
+   LCD_WRITE_BYTE( d );
+   if( LCD_IS_WRITE_ONLY() )
+      LCD_EXEC_WAIT();
+   else
+   { /*
+      * Releases the CPU during the execution time, if supported.
+      */
+      LCD_BUSY_SLEEP( d );
+   }
+   while( lcdIsBusy( LCD_OBJ_ &addr ) )
    {
      // DEBUG_MESSAGE( " %d\n", poll );
+      LCD_STATISTIC_INC( polls );
       poll--;
       if( poll == 0 )
       {
          ERROR_MESSAGE( ": Unable to set LCD-data %02X\n", d );
+         LCD_STATISTIC_INC( pollTimeouts );
+         LCD_TRACE( anLcd_poll_timeout, d );
          LCD_ERROR_HANDLING();
          break;
       }
       LCD_POLL_FUNCTION();
    }
+   LCD_BUS_TIME_ADD( t );
+   LCD_TRACE( anLcd_set_data, d, addr, CONFIG_TLCD_MAX_POLL - poll,
+              LCD_TRACE_ELAPSED( t ) );
    return addr;
 }
 
-/*----------------------------- lcdSetAddress ---------------------------------
+/*---------------------------- _lcdSetAddress ---------------------------------
 */
-LCD_ADDR_T lcdSetAddress( LCD_ADDR_T addr )
+static LCD_ADDR_T _lcdSetAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr )
 {
    LCD_ADDR_T ret;
+   LCD_TRACE_TIME_DECL( t );
 
    DEBUG_MESSAGE( ": %02X\n", addr );
+   LCD_TRACE_START( anLcd_set_address, t );
+   LCD_STATISTIC_INC( addressCmds );
    LCD_SELECT_INSTRUCTION();
-   ret = lcdSetData( addr | 0x80 );
+   lcdAcSetAddress( LCD_OBJ_ addr, FALSE );
+   ret = lcdSetData( LCD_OBJ_ addr | 0x80 );
+   LCD_TRACE( anLcd_set_address, addr, ret, LCD_TRACE_ELAPSED( t ) );
    if( ret != addr )
    {
       ERROR_MESSAGE( ": Unable to set address %02X -> %02X\n", addr, ret );
@@ -474,40 +871,213 @@ LCD_ADDR_T lcdSetAddress( LCD_ADDR_T addr )
    return ret;
 }
 
-/*------------------------------- lcdSetChar ----------------------------------
+#ifdef _LCD_VERIFY_ADDRESS
+/*---------------------------- lcdVerifyAddress -------------------------------
+ * Reads the address-counter from the controller and compares it with the
+ * imitated one, a difference becomes reported and the imitated
+ * address-counter corrected. For debugging purposes only.
+ * Returns TRUE if the controller is still busy.
+ */
+static BOOL lcdVerifyAddress( LCD_OBJ_DECL_ LCD_ADDR_T* pAddr )
+{
+   if( lcdIsBusy( LCD_OBJ_ pAddr ) )
+      return TRUE;
+   if( *pAddr != mg_ac.addr )
+   {
+      ERROR_MESSAGE( ": Address-counter %02X differs from %02X\n",
+                     *pAddr, mg_ac.addr );
+      mg_ac.addr = *pAddr;
+   }
+   return FALSE;
+}
+#endif
+
+/*----------------------------- lcdMoveAddress --------------------------------
+ * Sends a set-address command only if the imitated address-counter doesn't
+ * already point to addr, e.g. by the auto-increment of the controller.
+ * When _LCD_VERIFY_ADDRESS is defined, the address-counter becomes read
+ * back before a command is saved.
+ */
+static LCD_ADDR_T lcdMoveAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr )
+{
+#ifdef _LCD_VERIFY_ADDRESS
+   LCD_ADDR_T ac;
+
+   if( !mg_ac.isCgRam && (mg_ac.addr == addr) && !LCD_IS_WRITE_ONLY() )
+   {
+      if( lcdVerifyAddress( LCD_OBJ_ &ac ) || (ac != addr) )
+         return _lcdSetAddress( LCD_OBJ_ addr );
+   }
+#endif
+   if( !mg_ac.isCgRam && (mg_ac.addr == addr) )
+   {
+      LCD_STATISTIC_INC( addressSkips );
+      return addr;
+   }
+   return _lcdSetAddress( LCD_OBJ_ addr );
+}
+
+/*------------------------------ _lcdSetChar ----------------------------------
 */
-static
-LCD_ADDR_T lcdSetChar( char c )
+static LCD_ADDR_T _lcdSetChar( LCD_OBJ_DECL_ char c )
 {
+   LCD_ADDR_T addr;
+
+   LCD_STATISTIC_INC( chars );
    LCD_SELECT_DATA();
-   return lcdSetData( c );
+   lcdShadowStore( LCD_OBJ_ c );
+   lcdAcNext( LCD_OBJ );
+   addr = lcdSetData( LCD_OBJ_ c );
+   return addr;
+}
+
+/*-------------------------- _lcdSetDisplayState ------------------------------
+*/
+static LCD_ADDR_T _lcdSetDisplayState( LCD_OBJ_DECL_ BYTE state )
+{
+   LCD_SELECT_INSTRUCTION();
+#ifdef _LCD_SHADOW_RAM
+   mg_shadow.displayState = state;
+#endif
+   return lcdSetData( LCD_OBJ_ state | LCD_FLAG_CMD_ON_OFF_CTRL );
+}
+
+/*------------------------------ _lcdClrscr -----------------------------------
+*/
+static LCD_ADDR_T _lcdClrscr( LCD_OBJ_DECL )
+{
+   LCD_ADDR_T addr;
+
+   LCD_SELECT_INSTRUCTION();
+   lcdShadowClear( LCD_OBJ );
+   lcdAcSetAddress( LCD_OBJ_ 0, FALSE );
+   addr = lcdSetData( LCD_OBJ_ 0x01 );
+   if( LCD_IS_WRITE_ONLY() )
+      LCD_HOME_WAIT();
+   return addr;
 }
 
+#ifdef _LCD_SCREEN_MODEL
+/*----------------------------- lcdSetAddress ---------------------------------
+ * Sets the cursor of the screen-model only, the display-controller becomes
+ * updated by lcdFlush().
+ */
+LCD_ADDR_T lcdSetAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr )
+{
+   DEBUG_MESSAGE( ": %02X\n", addr );
+   if( (addr < 0) || (addr >= LCD_DDRAM_SIZE) ||
+       ((MAX_Y() > 1) && ((addr % LCD_MEM_LINE_SIZE) >= LCD_MEM_LINE_LEN)) )
+   {
+      ERROR_MESSAGE( ": Address %02X out of range!\n", addr );
+      return -1;
+   }
+   mg_screen.addr = addr;
+   return addr;
+}
+
+/*------------------------------- lcdSetChar ----------------------------------
+*/
+static LCD_ADDR_T lcdSetChar( LCD_OBJ_DECL_ char c )
+{
+   mg_screen.ddRam[mg_screen.addr] = c;
+   mg_screen.addr = lcdDdRamNextAddr( LCD_OBJ_ mg_screen.addr );
+   return mg_screen.addr;
+}
+
+/*------------------------------ lcdGetChar -----------------------------------
+*/
+char lcdGetChar( LCD_OBJ_DECL )
+{
+   char c = mg_screen.ddRam[mg_screen.addr];
+   mg_screen.addr = lcdDdRamNextAddr( LCD_OBJ_ mg_screen.addr );
+   return c;
+}
+
+/*----------------------------- lcdGetAddress ---------------------------------
+*/
+static INLINE BOOL lcdGetAddress( LCD_OBJ_DECL_ LCD_ADDR_T* pAddr )
+{
+   *pAddr = mg_screen.addr;
+   return FALSE;
+}
+
+/*-------------------------- lcdSetDisplayState -------------------------------
+*/
+static INLINE LCD_ADDR_T lcdSetDisplayState( LCD_OBJ_DECL )
+{
+   return mg_screen.addr;
+}
+
+#else /* ifdef _LCD_SCREEN_MODEL */
+
+/*----------------------------- lcdSetAddress ---------------------------------
+*/
+LCD_ADDR_T lcdSetAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr )
+{
+   return lcdMoveAddress( LCD_OBJ_ addr );
+}
+
+ #define lcdSetChar( c )         _lcdSetChar( LCD_OBJ_ c )
+ #define lcdSetDisplayState( o ) _lcdSetDisplayState( LCD_OBJ_ mg_displayState )
+
+ #if LCD_MAX_Y > 1
+/*------------------------------ lcdGetChar -----------------------------------
+ * Reads the character at the address-counter from the display-controller
+ * and increments the address-counter.
+ */
+char lcdGetChar( LCD_OBJ_DECL )
+{
+   return _lcdGetChar( LCD_OBJ );
+}
+ #endif
+
+/*----------------------------- lcdGetAddress ---------------------------------
+ * Returns the imitated address-counter, so it's not necessary to read it
+ * from the controller before each character. lcdSetData() waits until
+ * the busy-flag is cleared, therefore the controller isn't busy here.
+ * When _LCD_VERIFY_ADDRESS is defined, the address becomes compared with
+ * the address-counter of the controller.
+ */
+static INLINE BOOL lcdGetAddress( LCD_OBJ_DECL_ LCD_ADDR_T* pAddr )
+{
+#ifdef _LCD_VERIFY_ADDRESS
+   if( !LCD_IS_WRITE_ONLY() )
+      return lcdVerifyAddress( LCD_OBJ_ pAddr );
+#endif
+   *pAddr = mg_ac.addr;
+   return FALSE;
+}
+#endif /* else ifdef _LCD_SCREEN_MODEL */
+
 #ifndef CONFIG_LCD_MINIMAL
 /*------------------------------ lcdSetCgAddress ------------------------------
 */
-static INLINE LCD_ADDR_T lcdSetCgAddress( LCD_ADDR_T addr )
+static INLINE LCD_ADDR_T lcdSetCgAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr )
 {
    LCD_SELECT_INSTRUCTION();
-   return lcdSetData( (addr & 0x7F) | 0x40 );
+   lcdAcSetAddress( LCD_OBJ_ addr & 0x3F, TRUE );
+   return lcdSetData( LCD_OBJ_ (addr & 0x7F) | 0x40 );
 }
 
 /*------------------------------ lcdWriteCgRam --------------------------------
 */
-static INLINE LCD_ADDR_T lcdWriteCgRam( LCD_ADDR_T addr, BYTE data )
+static INLINE LCD_ADDR_T lcdWriteCgRam( LCD_OBJ_DECL_ LCD_ADDR_T addr, BYTE data )
 {
-   addr = lcdSetCgAddress( addr );
+   addr = lcdSetCgAddress( LCD_OBJ_ addr );
    if( addr < 0 )
       return addr;
-   return lcdSetChar( data );
+   return _lcdSetChar( LCD_OBJ_ data );
 }
 
 /*---------------------------- lcdLoadExtraCharP ------------------------------
 */
-LCD_ADDR_T lcdLoadExtraCharP( const LCD_CGRAM_CHAR_T extraChar, BYTE position )
+LCD_ADDR_T lcdLoadExtraCharP( LCD_OBJ_DECL_ const LCD_CGRAM_CHAR_T extraChar, BYTE position )
 {
    LCD_INDEX_T i;
    LCD_ADDR_T addr;
+#ifndef _LCD_SCREEN_MODEL
+   const LCD_ADDR_T ddRamAddr = mg_ac.isCgRam? 0 : mg_ac.addr;
+#endif
 
    if( position > LCD_MAX_CG_RAM )
    {
@@ -520,10 +1090,18 @@ LCD_ADDR_T lcdLoadExtraCharP( const LCD_CGRAM_CHAR_T extraChar, BYTE position )
    position *= sizeof( LCD_CGRAM_CHAR_T );
    for( i = 0; i < sizeof( LCD_CGRAM_CHAR_T ); i++ )
    {
-      addr = lcdWriteCgRam( position++, LCD_PGM_READ_BYTE( extraChar++ ) );
+      addr = lcdWriteCgRam( LCD_OBJ_ position++, LCD_PGM_READ_BYTE( extraChar++ ) );
       if( addr < 0 )
-         break;
+         return addr;
    }
+#ifndef _LCD_SCREEN_MODEL
+   /*
+    * Restoring of the DD-RAM address, the remembered address-counter
+    * makes reading it back before unnecessary. In the case of the
+    * screen-model lcdFlush() restores the address.
+    */
+   addr = _lcdSetAddress( LCD_OBJ_ ddRamAddr );
+#endif
    return addr;
 }
 
@@ -532,7 +1110,7 @@ LCD_ADDR_T lcdLoadExtraCharP( const LCD_CGRAM_CHAR_T extraChar, BYTE position )
 #if LCD_MAX_Y > 1
 /*------------------------------- lcdAddr2Line --------------------------------
 */
-BYTE lcdAddr2Line( LCD_ADDR_T addr )
+BYTE lcdAddr2Line( LCD_OBJ_DECL_ LCD_ADDR_T addr )
 {
    if( addr < MAX_X() )
       return 0;
@@ -555,7 +1133,7 @@ BYTE lcdAddr2Line( LCD_ADDR_T addr )
 
 /*---------------------------- lcdLine2Addr -----------------------------------
 */
-LCD_ADDR_T lcdLine2Addr( BYTE y )
+LCD_ADDR_T lcdLine2Addr( LCD_OBJ_DECL_ BYTE y )
 {
    switch( y )
    {
@@ -572,9 +1150,9 @@ LCD_ADDR_T lcdLine2Addr( BYTE y )
 
 /*---------------------------- lcdAddr2LineAddr -------------------------------
 */
-static LCD_ADDR_T lcdAddr2LineAddr( LCD_ADDR_T addr )
+static LCD_ADDR_T lcdAddr2LineAddr( LCD_OBJ_DECL_ LCD_ADDR_T addr )
 {
-   return lcdLine2Addr( lcdAddr2Line( addr ) );
+   return lcdLine2Addr( LCD_OBJ_ lcdAddr2Line( LCD_OBJ_ addr ) );
 }
 
 #else
@@ -583,9 +1161,188 @@ static LCD_ADDR_T lcdAddr2LineAddr( LCD_ADDR_T addr )
  #define lcdAddr2LineAddr( x ) 0
 #endif
 
+#ifdef _LCD_SHADOW_RAM
+/*---------------------------- lcdGetShadowChar -------------------------------
+ * Returns the character at the zero based position x, y from the RAM-copy
+ * of the DD-RAM without any access to the display-controller.
+ */
+char lcdGetShadowChar( LCD_OBJ_DECL_ BYTE x, BYTE y )
+{
+   return mg_shadow.ddRam[(lcdLine2Addr( LCD_OBJ_ y ) + x) & (LCD_DDRAM_SIZE - 1)];
+}
+
+/*-------------------------- lcdGetShadowAddress ------------------------------
+*/
+LCD_ADDR_T lcdGetShadowAddress( LCD_OBJ_DECL )
+{
+   return mg_shadow.addr;
+}
+
+#if (LCD_MAX_Y > 1) || defined(__KERNEL__) || defined(_LCD_SCREEN_MODEL)
+ #ifndef CONFIG_LCD_MINIMAL
+/*------------------------------ lcdVerifyBus ---------------------------------
+ * Writes a test-pattern in the last character of the CG-RAM and reads it
+ * back, afterwards the character becomes restored from the RAM-copy.
+ * Returns TRUE if the read back pattern matches. Used for the calibration
+ * of the bus-timing, so it requires a readable bus (pin r/w connected).
+ */
+BOOL lcdVerifyBus( LCD_OBJ_DECL )
+{
+   static const BYTE pattern[sizeof( LCD_CGRAM_CHAR_T )] =
+   {
+      0x15, 0x0A, 0x1F, 0x00, 0x11, 0x0E, 0x03, 0x18
+   };
+   const LCD_ADDR_T base = (LCD_CGRAM_CHARS - 1) * sizeof( LCD_CGRAM_CHAR_T );
+   LCD_CGRAM_CHAR_T save;
+   LCD_INDEX_T i;
+   BOOL ret = TRUE;
+
+   memcpy( save, mg_shadow.cgRam[LCD_CGRAM_CHARS - 1], sizeof( save ) );
+   if( lcdSetCgAddress( LCD_OBJ_ base ) < 0 )
+      return FALSE;
+   for( i = 0; i < sizeof( pattern ); i++ )
+      _lcdSetChar( LCD_OBJ_ pattern[i] );
+
+   if( lcdSetCgAddress( LCD_OBJ_ base ) < 0 )
+      return FALSE;
+   /*
+    * The CG-RAM of a 5x8 character has 5 significant bits only.
+    */
+   for( i = 0; i < sizeof( pattern ); i++ )
+   {
+      if( (_lcdGetChar( LCD_OBJ ) & 0x1F) != pattern[i] )
+         ret = FALSE;
+   }
+
+   if( lcdSetCgAddress( LCD_OBJ_ base ) < 0 )
+      return FALSE;
+   for( i = 0; i < sizeof( save ); i++ )
+      _lcdSetChar( LCD_OBJ_ save[i] );
+   return ret;
+}
+ #endif /* ifndef CONFIG_LCD_MINIMAL */
+
+/*------------------------------ lcdReadChar ----------------------------------
+ * Reads the character at the zero based position x, y directly from the
+ * display-controller. For verifying purposes only.
+ */
+char lcdReadChar( LCD_OBJ_DECL_ BYTE x, BYTE y )
+{
+   if( _lcdSetAddress( LCD_OBJ_ lcdLine2Addr( LCD_OBJ_ y ) + x ) < 0 )
+      return '\0';
+   return _lcdGetChar( LCD_OBJ );
+}
+#endif /* if (LCD_MAX_Y > 1) || defined(__KERNEL__) || defined(_LCD_SCREEN_MODEL) */
+#endif /* ifdef _LCD_SHADOW_RAM */
+
+#ifdef _LCD_SCREEN_MODEL
+/*---------------------------- lcdGetScreenChar -------------------------------
+ * Returns the character at the zero based position x, y of the screen-model.
+ */
+char lcdGetScreenChar( LCD_OBJ_DECL_ BYTE x, BYTE y )
+{
+   return mg_screen.ddRam[(lcdLine2Addr( LCD_OBJ_ y ) + x) & (LCD_DDRAM_SIZE - 1)];
+}
+
+/*----------------------------- lcdRowLength ----------------------------------
+ * Returns the number of visible cells in the DD-RAM row beginning at
+ * row * LCD_MEM_LINE_SIZE. In the 4-line mode the lines 0 and 2 respectively
+ * 1 and 3 are following directly one after the other in the same row.
+ */
+static LCD_ADDR_T lcdRowLength( LCD_OBJ_DECL_ BYTE row )
+{
+   if( MAX_Y() == 1 )
+      return (row == 0)? MAX_X() : 0;
+   return MAX_X() * ((MAX_Y() > (row + 2))? 2 : 1);
+}
+
+/*------------------------------ lcdIsBlank -----------------------------------
+ * Returns TRUE if all visible cells of the screen-model are blank and
+ * counts the visible cells which differs from the display.
+ */
+static BOOL lcdIsBlank( LCD_OBJ_DECL_ LCD_INDEX_T* pDirty )
+{
+   BYTE row;
+   LCD_ADDR_T addr, end;
+   BOOL isBlank = TRUE;
+
+   *pDirty = 0;
+   for( row = 0; row < 2; row++ )
+   {
+      addr = row * LCD_MEM_LINE_SIZE;
+      for( end = addr + lcdRowLength( LCD_OBJ_ row ); addr < end; addr++ )
+      {
+         if( mg_frame.ddRam[addr] != ' ' )
+            isBlank = FALSE;
+         if( mg_frame.ddRam[addr] != mg_shadow.ddRam[addr] )
+            (*pDirty)++;
+      }
+   }
+   return isBlank;
+}
+
+/*-------------------------------- lcdFlush -----------------------------------
+ * Transfers the differences between the screen-model and the RAM-copy of the
+ * display-controller to the display. The cells becomes written in order of
+ * its DD-RAM address, so the auto-increment of the controller can be used
+ * and a set-address command is only necessary after a gap of unchanged cells.
+ */
+LCD_ADDR_T lcdFlush( LCD_OBJ_DECL )
+{
+   BYTE row;
+   LCD_ADDR_T addr, end, next;
+   LCD_INDEX_T dirty;
+
+   if( mg_frameDisplayState != mg_shadow.displayState )
+   {
+      if( _lcdSetDisplayState( LCD_OBJ_ mg_frameDisplayState ) < 0 )
+         return -1;
+   }
+
+   /*
+    * A single clear-command is cheaper than writing a lot of blanks.
+    */
+   if( lcdIsBlank( LCD_OBJ_ &dirty ) && (dirty > MAX_X()) )
+   {
+      if( _lcdClrscr( LCD_OBJ ) < 0 )
+         return -1;
+   }
+
+   next = -1;
+   for( row = 0; (row < 2) && (dirty > 0); row++ )
+   {
+      addr = row * LCD_MEM_LINE_SIZE;
+      for( end = addr + lcdRowLength( LCD_OBJ_ row ); addr < end; addr++ )
+      {
+         if( mg_frame.ddRam[addr] == mg_shadow.ddRam[addr] )
+            continue;
+         /*
+          * Begin of a run of changed cells. The address-counter can be
+          * already there, e.g. after a clear-command or when a 40 columns
+          * line continues in the next row.
+          */
+         if( (addr != next) && (lcdMoveAddress( LCD_OBJ_ addr ) < 0) )
+            return -1;
+         if( _lcdSetChar( LCD_OBJ_ mg_frame.ddRam[addr] ) < 0 )
+            return -1;
+         next = addr + 1;
+      }
+   }
+
+   /*
+    * The address-counter of the controller has to follow the cursor
+    * of the screen-model only if the cursor is visible.
+    */
+   if( (mg_frameDisplayState & (LCD_FLAG_CURSOR_ON | LCD_FLAG_BLINK_ON)) != 0 )
+      return lcdMoveAddress( LCD_OBJ_ mg_frame.addr );
+
+   return mg_shadow.addr;
+}
+#endif /* ifdef _LCD_SCREEN_MODEL */
+
 /*----------------------------- lcdGotoXY -------------------------------------
 */
-LCD_ADDR_T lcdGotoXY( BYTE x, BYTE y )
+LCD_ADDR_T lcdGotoXY( LCD_OBJ_DECL_ BYTE x, BYTE y )
 {
    BOOL error = FALSE;
    DEBUG_MESSAGE( ": x=%d, y=%d\n", x, y );
@@ -606,72 +1363,71 @@ LCD_ADDR_T lcdGotoXY( BYTE x, BYTE y )
 #if (LCD_MAX_Y > 2) || defined(__KERNEL__)
    mg_lastChar = ((x == MAX_X()) && (y == MAX_Y()));
 #endif
-   return lcdSetAddress( (x-1) + lcdLine2Addr( y-1 ) );
+   return lcdSetAddress( LCD_OBJ_ (x-1) + lcdLine2Addr( LCD_OBJ_ y-1 ) );
 }
 
 /*----------------------------- lcdCursorOn -----------------------------------
 */
-LCD_ADDR_T lcdCursorOn( void )
+LCD_ADDR_T lcdCursorOn( LCD_OBJ_DECL )
 {
    DEBUG_MESSAGE( "\n" );
-   LCD_SELECT_INSTRUCTION();
    mg_displayState |= LCD_FLAG_CURSOR_ON;
-   return lcdSetData( mg_displayState | LCD_FLAG_CMD_ON_OFF_CTRL );
+   return lcdSetDisplayState( LCD_OBJ );
 }
 
 /*----------------------------- lcdCursorOff ----------------------------------
 */
-LCD_ADDR_T lcdCursorOff( void )
+LCD_ADDR_T lcdCursorOff( LCD_OBJ_DECL )
 {
    DEBUG_MESSAGE( "\n" );
-   LCD_SELECT_INSTRUCTION();
    mg_displayState &= ~(LCD_FLAG_CURSOR_ON | LCD_FLAG_BLINK_ON);
-   return lcdSetData( mg_displayState | LCD_FLAG_CMD_ON_OFF_CTRL );
+   return lcdSetDisplayState( LCD_OBJ );
 }
 
 /*---------------------------- lcdCursorBlink ---------------------------------
 */
-LCD_ADDR_T lcdCursorBlink( void )
+LCD_ADDR_T lcdCursorBlink( LCD_OBJ_DECL )
 {
    DEBUG_MESSAGE( "\n" );
-   LCD_SELECT_INSTRUCTION();
    mg_displayState |= LCD_FLAG_BLINK_ON;
-   return lcdSetData( mg_displayState | LCD_FLAG_CMD_ON_OFF_CTRL );
+   return lcdSetDisplayState( LCD_OBJ );
 }
 
 /*--------------------------------- lcdOn -------------------------------------
 */
-LCD_ADDR_T lcdOn( void )
+LCD_ADDR_T lcdOn( LCD_OBJ_DECL )
 {
    DEBUG_MESSAGE( "\n" );
-   LCD_SELECT_INSTRUCTION();
    mg_displayState |= LCD_FLAG_DISPLAY_ON;
-   return lcdSetData( mg_displayState | LCD_FLAG_CMD_ON_OFF_CTRL );
+   return lcdSetDisplayState( LCD_OBJ );
 }
 
 /*--------------------------------- lcdOff ------------------------------------
 */
-LCD_ADDR_T lcdOff( void )
+LCD_ADDR_T lcdOff( LCD_OBJ_DECL )
 {
    DEBUG_MESSAGE( "\n" );
-   LCD_SELECT_INSTRUCTION();
    mg_displayState &= ~LCD_FLAG_DISPLAY_ON;
-   return lcdSetData( mg_displayState | LCD_FLAG_CMD_ON_OFF_CTRL );
+   return lcdSetDisplayState( LCD_OBJ );
 }
 
 /*--------------------------------- lcdClrscr ---------------------------------
 */
-LCD_ADDR_T lcdClrscr( void )
+LCD_ADDR_T lcdClrscr( LCD_OBJ_DECL )
 {
    mg_lastChar = FALSE;
    DEBUG_MESSAGE( "\n" );
-   LCD_SELECT_INSTRUCTION();
-   return lcdSetData( 0x01 );
+#ifdef _LCD_SCREEN_MODEL
+   lcdScreenClear( LCD_OBJ );
+   return mg_screen.addr;
+#else
+   return _lcdClrscr( LCD_OBJ );
+#endif
 }
 
 /*-------------------------------- lcdDelLine ---------------------------------
 */
-LCD_ADDR_T lcdDelLine( BYTE x )
+LCD_ADDR_T lcdDelLine( LCD_OBJ_DECL_ BYTE x )
 {
    LCD_ADDR_T addr, i;
 
@@ -683,26 +1439,25 @@ LCD_ADDR_T lcdDelLine( BYTE x )
       return -1;
    }
 
-   LCD_SELECT_INSTRUCTION();
-   if( lcdIsBusy( &addr ) )
+   if( lcdGetAddress( LCD_OBJ_ &addr ) )
       return addr;
 
    x--;
-   addr = lcdSetAddress( x + lcdAddr2LineAddr( addr ) );
+   addr = lcdSetAddress( LCD_OBJ_ x + lcdAddr2LineAddr( LCD_OBJ_ addr ) );
    if( addr < 0 )
       return addr;
    for( i = x; i < MAX_X(); i++ )
    {
-      addr = lcdSetChar( ' ' );
+      addr = lcdSetChar( LCD_OBJ_ ' ' );
       if( addr < 0 )
          return addr;
    }
  #if (LCD_MAX_Y > 2) || defined(__KERNEL__)
    mg_lastChar = (x == MAX_X()-1);
    if( addr == 0 )
-      return lcdSetAddress( LCD_MEM_LINE_SIZE + MAX_X() );
+      return lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE + MAX_X() );
  #endif
-   return lcdSetAddress( addr + x - MAX_X() );
+   return lcdSetAddress( LCD_OBJ_ addr + x - MAX_X() );
 }
 
 #if (LCD_MAX_Y > 1) || defined(__KERNEL__)
@@ -712,9 +1467,82 @@ LCD_ADDR_T lcdDelLine( BYTE x )
    #define o2 0
 #endif
 
+#ifdef _LCD_SCREEN_MODEL
+/*---------------------------- lcdScreenCopyLine ------------------------------
+ * Copies the line ySrc of the screen-model to the line yDest.
+ * Not any bus-access is necessary, the display becomes updated by lcdFlush().
+ */
+static void lcdScreenCopyLine( LCD_OBJ_DECL_ BYTE yDest, BYTE ySrc )
+{
+   memcpy( &mg_screen.ddRam[lcdLine2Addr( LCD_OBJ_ yDest )],
+           &mg_screen.ddRam[lcdLine2Addr( LCD_OBJ_ ySrc )], MAX_X() );
+}
+
+/*---------------------------- lcdScreenClearLine -----------------------------
+*/
+static LCD_ADDR_T lcdScreenClearLine( LCD_OBJ_DECL_ BYTE y )
+{
+   memset( &mg_screen.ddRam[lcdLine2Addr( LCD_OBJ_ y )], ' ', MAX_X() );
+   mg_lastChar = FALSE;
+   mg_screen.addr = lcdLine2Addr( LCD_OBJ_ y );
+   return mg_screen.addr;
+}
+
 /*-------------------------------- lcdScrollUp --------------------------------
 */
-LCD_ADDR_T lcdScrollUp( void )
+LCD_ADDR_T lcdScrollUp( LCD_OBJ_DECL )
+{
+   LCD_INDEX_T y;
+
+   DEBUG_MESSAGE( "\n" );
+   for( y = 0; y < (MAX_Y() - 1); y++ )
+      lcdScreenCopyLine( LCD_OBJ_ y, y + 1 );
+   return lcdScreenClearLine( LCD_OBJ_ MAX_Y() - 1 );
+}
+
+/*---------------------------- lcdScrollDown ----------------------------------
+*/
+LCD_ADDR_T lcdScrollDown( LCD_OBJ_DECL )
+{
+   LCD_INDEX_T y;
+
+   DEBUG_MESSAGE( "\n" );
+   for( y = MAX_Y() - 1; y > 0; y-- )
+      lcdScreenCopyLine( LCD_OBJ_ y, y - 1 );
+   return lcdScreenClearLine( LCD_OBJ_ 0 );
+}
+
+#else /* ifdef _LCD_SCREEN_MODEL */
+
+/*------------------------------- lcdReadLine ---------------------------------
+ * Copies MAX_X() characters beginning at the DD-RAM address addr into data.
+ * With _LCD_SHADOW_RAM they are taken from the RAM-copy without any
+ * bus-access, otherwise they become read back from the controller.
+ */
+static LCD_ADDR_T lcdReadLine( LCD_OBJ_DECL_ LCD_ADDR_T addr, BYTE* data )
+{
+   LCD_ADDR_T x;
+
+#ifdef _LCD_SHADOW_RAM
+   for( x = 0; x < MAX_X(); x++ )
+      data[x] = mg_shadow.ddRam[(addr + x) & (LCD_DDRAM_SIZE - 1)];
+#else
+   addr = lcdSetAddress( LCD_OBJ_ addr );
+   if( addr < 0 )
+      return addr;
+
+   for( x = 0; x < MAX_X(); x++ )
+   {
+      data[x] = lcdGetChar( LCD_OBJ );
+      DEBUG_MESSAGE( ": %02X %c\n", data[x], data[x] );
+   }
+#endif
+   return addr;
+}
+
+/*-------------------------------- lcdScrollUp --------------------------------
+*/
+LCD_ADDR_T lcdScrollUp( LCD_OBJ_DECL )
 {
    LCD_ADDR_T addr, x;
    BYTE data[MAX_X()];
@@ -725,41 +1553,35 @@ LCD_ADDR_T lcdScrollUp( void )
    DEBUG_MESSAGE( "\n" );
    for( y = 0; y < (MAX_Y() - 1); y++ )
    {
-      o1 = lcdLine2Addr( y + 1 );
-      o2 = lcdLine2Addr( y );
+      o1 = lcdLine2Addr( LCD_OBJ_ y + 1 );
+      o2 = lcdLine2Addr( LCD_OBJ_ y );
 #endif
-      addr = lcdSetAddress( o1 );
+      addr = lcdReadLine( LCD_OBJ_ o1, data );
       if( addr < 0 )
          return addr;
 
-      for( x = 0; x < MAX_X(); x++ )
-      {
-         data[x] = lcdGetChar();
-         DEBUG_MESSAGE( ": %02X %c\n", data[x], data[x] );
-      }
-
-      addr = lcdSetAddress( o2 );
+      addr = lcdSetAddress( LCD_OBJ_ o2 );
       if( addr < 0 )
          return addr;
 
       for( x = 0; x < MAX_X(); x++ )
       {
-         addr = lcdSetChar( data[x] );
+         addr = lcdSetChar( LCD_OBJ_ data[x] );
          if( addr < 0 )
             return addr;
       }
 #if (LCD_MAX_Y > 2) || defined(__KERNEL__)
    }
 #endif
-   addr = lcdSetAddress( o1 );
+   addr = lcdSetAddress( LCD_OBJ_ o1 );
    if( addr < 0 )
       return addr;
-   return lcdDelLine( 1 );
+   return lcdDelLine( LCD_OBJ_ 1 );
 }
 
 /*---------------------------- lcdScrollDown ----------------------------------
 */
-LCD_ADDR_T lcdScrollDown( void )
+LCD_ADDR_T lcdScrollDown( LCD_OBJ_DECL )
 {
    LCD_ADDR_T addr, x;
    BYTE data[MAX_X()];
@@ -770,26 +1592,20 @@ LCD_ADDR_T lcdScrollDown( void )
    DEBUG_MESSAGE( "\n" );
    for( y = MAX_Y()-1; y > 0; y-- )
    {
-      o1 = lcdLine2Addr( y );
-      o2 = lcdLine2Addr( y - 1 );
+      o1 = lcdLine2Addr( LCD_OBJ_ y );
+      o2 = lcdLine2Addr( LCD_OBJ_ y - 1 );
 #endif
-      addr = lcdSetAddress( o2 );
+      addr = lcdReadLine( LCD_OBJ_ o2, data );
       if( addr < 0 )
          return addr;
 
-      for( x = 0; x < MAX_X(); x++ )
-      {
-         data[x] = lcdGetChar();
-         DEBUG_MESSAGE( ": %02X %c\n", data[x], data[x] );
-      }
-
-      addr = lcdSetAddress( o1 );
+      addr = lcdSetAddress( LCD_OBJ_ o1 );
       if( addr < 0 )
          return addr;
 
       for( x = 0; x < MAX_X(); x++ )
       {
-         addr = lcdSetChar( data[x] );
+         addr = lcdSetChar( LCD_OBJ_ data[x] );
          if( addr < 0 )
            return addr;
       }
@@ -797,11 +1613,12 @@ LCD_ADDR_T lcdScrollDown( void )
 #if (LCD_MAX_Y > 2) || defined(__KERNEL__)
    }
 #endif
-   addr = lcdSetAddress( 0 );
+   addr = lcdSetAddress( LCD_OBJ_ 0 );
    if( addr < 0 )
       return addr;
-   return lcdDelLine( 1 );
+   return lcdDelLine( LCD_OBJ_ 1 );
 }
+#endif /* else ifdef _LCD_SCREEN_MODEL */
 
 #if LCD_MAX_Y == 2 && !defined(__KERNEL__)
    #undef o1
@@ -902,18 +1719,12 @@ BOOL lcdConvertBackChar8( char* pChar )
 
 /*----------------------------- lcdPutch --------------------------------------
 */
-LCD_ADDR_T lcdPutch( char c )
+LCD_ADDR_T lcdPutch( LCD_OBJ_DECL_ char c )
 {
 #ifndef _LCD_MINIMAL
    LCD_ADDR_T addr;
    BOOL isLastLine;
- #if !(defined( CONFIG_LCD_NO_UMLAUT ) && defined( CONFIG_LCD_NO_TERMINAL ))
-  #ifndef CONFIG_LCD_NO_TERMINAL
-   static TERMINAL_T  parameter[2];
-   static LCD_INDEX_T i = 0;
-  #endif
- #endif
-   if( lcdIsBusy( &addr ) )
+   if( lcdGetAddress( LCD_OBJ_ &addr ) )
    {
       DEBUG_MESSAGE( ": LCD is still busy!\n" );
       return addr;
@@ -944,9 +1755,9 @@ LCD_ADDR_T lcdPutch( char c )
       {
          if( c == '[' )
          {
-            for( i = 0; i < ARRAY_SIZE( parameter ); i++ )
-               parameter[i] = 0;
-            i = 0;
+            for( mg_escIndex = 0; mg_escIndex < ARRAY_SIZE( mg_escParameter ); mg_escIndex++ )
+               mg_escParameter[mg_escIndex] = 0;
+            mg_escIndex = 0;
             TRANSITION( LCD_CTRL );
             return addr;
          }
@@ -965,24 +1776,24 @@ LCD_ADDR_T lcdPutch( char c )
             case 'H':
             {
                TRANSITION( LCD_NORMAL );
-               if( i == 0 )
-                  return lcdClrscr();
-               return lcdGotoXY( parameter[1], parameter[0] );
+               if( mg_escIndex == 0 )
+                  return lcdClrscr( LCD_OBJ );
+               return lcdGotoXY( LCD_OBJ_ mg_escParameter[1], mg_escParameter[0] );
             }
             case 'J': return addr;
             case 'M':
             {
                TRANSITION( LCD_NORMAL );
-               return lcdDelLine( parameter[0] );
+               return lcdDelLine( LCD_OBJ_ mg_escParameter[0] );
             }
             case ';':
             {
-               i++;
-               if( i >= ARRAY_SIZE( parameter ) )
+               mg_escIndex++;
+               if( mg_escIndex >= ARRAY_SIZE( mg_escParameter ) )
                {
-                  i = 0;
+                  mg_escIndex = 0;
                   ERROR_MESSAGE( ": Not more then %d parameter for escape sequences allowed!\n",
-                                  ARRAY_SIZE( parameter ) );
+                                  ARRAY_SIZE( mg_escParameter ) );
                   TRANSITION( LCD_NORMAL );
                }
                return addr; /* Only 2 parameters allowed. */
@@ -995,9 +1806,9 @@ LCD_ADDR_T lcdPutch( char c )
          }
          if( c >= '0' && c <= '9' )
          {
-            ASSERT( i < ARRAY_SIZE( parameter ) );
-            parameter[i] *= 10;
-            parameter[i] += c - '0';
+            ASSERT( mg_escIndex < ARRAY_SIZE( mg_escParameter ) );
+            mg_escParameter[mg_escIndex] *= 10;
+            mg_escParameter[mg_escIndex] += c - '0';
             return addr;
          }
          break;
@@ -1011,12 +1822,12 @@ LCD_ADDR_T lcdPutch( char c )
             case 'l':
             {
                TRANSITION( LCD_NORMAL );
-               return lcdCursorOff();
+               return lcdCursorOff( LCD_OBJ );
             }
             case 'h':
             {
                TRANSITION( LCD_NORMAL );
-               return lcdCursorOn();
+               return lcdCursorOn( LCD_OBJ );
             }
             //! @todo Esc-sequence for blink-corsor.  
          }
@@ -1028,7 +1839,7 @@ LCD_ADDR_T lcdPutch( char c )
    TRANSITION( LCD_NORMAL );
  #endif /* if !(defined( CONFIG_LCD_NO_UMLAUT ) && defined( CONFIG_LCD_NO_TERMINAL )) */
 
-   isLastLine = (MAX_Y()-1 == lcdAddr2Line( addr ));
+   isLastLine = (MAX_Y()-1 == lcdAddr2Line( LCD_OBJ_ addr ));
    DEBUG_MESSAGE( ":addr = %02X c = %c, %02X\n", addr, c, c );
    switch( c )
    {
@@ -1052,7 +1863,7 @@ LCD_ADDR_T lcdPutch( char c )
       case '\n':
       case '\r':
       {
-         addr = lcdAddr2LineAddr( addr );
+         addr = lcdAddr2LineAddr( LCD_OBJ_ addr );
        #if (LCD_MAX_Y > 1) || defined(__KERNEL__)
          if( (c == '\n' )
           #ifdef __KERNEL__
@@ -1061,16 +1872,16 @@ LCD_ADDR_T lcdPutch( char c )
            )
          {
             if( mg_lcdAutoScroll && isLastLine )
-               return lcdScrollUp();
+               return lcdScrollUp( LCD_OBJ );
            #if (LCD_MAX_Y == 2) && !defined(__KERNEL__)
              addr += LCD_MEM_LINE_SIZE;
            #else
-             addr = lcdLine2Addr( lcdAddr2Line( addr ) + 1 );
+             addr = lcdLine2Addr( LCD_OBJ_ lcdAddr2Line( LCD_OBJ_ addr ) + 1 );
            #endif
 
          }
        #endif /* if (LCD_MAX_Y > 1) || defined(__KERNEL__) */
-         return lcdSetAddress( addr );
+         return lcdSetAddress( LCD_OBJ_ addr );
       }
     #ifndef CONFIG_LCD_NO_BACKSPACE
       case '\b': // Backspace
@@ -1085,16 +1896,16 @@ LCD_ADDR_T lcdPutch( char c )
          else
             addr--;
        #else
-         if( lcdAddr2LineAddr( addr ) == addr )
-            addr = lcdLine2Addr( lcdAddr2Line( addr ) - 1 ) + MAX_X()-1;
+         if( lcdAddr2LineAddr( LCD_OBJ_ addr ) == addr )
+            addr = lcdLine2Addr( LCD_OBJ_ lcdAddr2Line( LCD_OBJ_ addr ) - 1 ) + MAX_X()-1;
          else
             addr--;
        #endif
        //#ifdef _LCD_DEL_CHAR_IF_BACKSPACE
-         lcdSetAddress( addr );
-         lcdSetChar( ' ' );
+         lcdSetAddress( LCD_OBJ_ addr );
+         lcdSetChar( LCD_OBJ_ ' ' );
       // #endif
-         return lcdSetAddress( addr );
+         return lcdSetAddress( LCD_OBJ_ addr );
       }
     #endif
     #if !defined( CONFIG_LCD_NO_VERTICAL_FEED ) && ((LCD_MAX_Y > 1) || defined(__KERNEL__))
@@ -1105,12 +1916,12 @@ LCD_ADDR_T lcdPutch( char c )
           #if (LCD_MAX_Y == 2) && !defined(__KERNEL__)
             addr += LCD_MEM_LINE_SIZE;
           #elif (LCD_MAX_Y == 4) || defined(__KERNEL__)
-            addr = lcdLine2Addr( lcdAddr2Line( addr ) + 1 ) + (addr - lcdAddr2LineAddr( addr ));
+            addr = lcdLine2Addr( LCD_OBJ_ lcdAddr2Line( LCD_OBJ_ addr ) + 1 ) + (addr - lcdAddr2LineAddr( LCD_OBJ_ addr ));
           #endif
          }
          else if( mg_lcdAutoScroll )
-            lcdScrollUp();
-         return lcdSetAddress( addr );
+            lcdScrollUp( LCD_OBJ );
+         return lcdSetAddress( LCD_OBJ_ addr );
       }
     #endif
     #ifdef LCD_BELL_FUNCTION
@@ -1133,9 +1944,9 @@ LCD_ADDR_T lcdPutch( char c )
    {
       mg_lastChar = FALSE;
       if( mg_lcdAutoScroll )
-         addr = lcdScrollUp();
+         addr = lcdScrollUp( LCD_OBJ );
    }
-   addr = lcdSetChar( c );
+   addr = lcdSetChar( LCD_OBJ_ c );
 #if (LCD_MAX_Y > 1) || defined(__KERNEL__)
  #ifdef __KERNEL__
    if( MAX_Y() > 1 )
@@ -1144,26 +1955,26 @@ LCD_ADDR_T lcdPutch( char c )
 #if 1
       if( addr == MAX_X() )
       {
-         addr = lcdSetAddress( LCD_MEM_LINE_SIZE );
+         addr = lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE );
       }
       else if( addr == (LCD_MEM_LINE_SIZE + MAX_X()) )
       {
       #ifdef __KERNEL__
          if( MAX_Y() > 2 )
          {
-            addr = lcdSetAddress( MAX_X() );
+            addr = lcdSetAddress( LCD_OBJ_ MAX_X() );
          }
          else
          {
             mg_lastChar = TRUE;
-            //!! addr = lcdSetAddress( LCD_MEM_LINE_SIZE );
+            //!! addr = lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE );
          }
       #else
        #if (LCD_MAX_Y > 2)
-         addr = lcdSetAddress( LCD_MAX_X );
+         addr = lcdSetAddress( LCD_OBJ_ LCD_MAX_X );
        #else
          mg_lastChar = TRUE;
-         addr = lcdSetAddress( LCD_MEM_LINE_SIZE );
+         addr = lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE );
        #endif
       #endif
       }
@@ -1173,20 +1984,27 @@ LCD_ADDR_T lcdPutch( char c )
      #ifdef __KERNEL__
          if( MAX_Y() > 3 )
          {
-            addr = lcdSetAddress( LCD_MEM_LINE_SIZE + MAX_X() );
+            addr = lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE + MAX_X() );
+         }
+         else if( MAX_Y() == 2 )
+         {
+           /*
+            * Line with 40 columns, the auto-increment of the controller
+            * has been continued in the second line already.
+            */
          }
          else
          {
             mg_lastChar = TRUE;
-            addr = lcdSetAddress( MAX_X() );
+            addr = lcdSetAddress( LCD_OBJ_ MAX_X() );
          }
      #else
        #if (LCD_MAX_Y > 3)
-         addr = lcdSetAddress( LCD_MEM_LINE_SIZE + LCD_MAX_X );
+         addr = lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE + LCD_MAX_X );
          break;
        #else
          mg_lastChar = TRUE;
-         addr = lcdSetAddress( LCD_MAX_X );
+         addr = lcdSetAddress( LCD_OBJ_ LCD_MAX_X );
        #endif
      #endif
       }
@@ -1194,7 +2012,7 @@ LCD_ADDR_T lcdPutch( char c )
       else if( addr == 0 )
       {
          mg_lastChar = TRUE;
-         addr = lcdSetAddress( LCD_MEM_LINE_SIZE + MAX_X() );
+         addr = lcdSetAddress( LCD_OBJ_ LCD_MEM_LINE_SIZE + MAX_X() );
       }
     #endif /* (LCD_MAX_Y > 2) || defined(__KERNEL__) */
     #endif /* (LCD_MAX_Y > 3) || defined(__KERNEL__) */
@@ -1204,7 +2022,7 @@ LCD_ADDR_T lcdPutch( char c )
         if( (addr / LCD_MEM_LINE_SIZE) == (MAX_Y() - 1) )
            mg_lastChar = TRUE;
         else
-           addr = lcdSetAddress( addr - MAX_X() + LCD_MEM_LINE_SIZE );
+           addr = lcdSetAddress( LCD_OBJ_ addr - MAX_X() + LCD_MEM_LINE_SIZE );
     }
 #endif
  #ifdef __KERNEL__
@@ -1214,21 +2032,21 @@ LCD_ADDR_T lcdPutch( char c )
  #endif
     #else /* (LCD_MAX_Y > 1) || defined(__KERNEL__) */
       if( addr == MAX_X() )
-         addr = lcdSetAddress( 0 );
+         addr = lcdSetAddress( LCD_OBJ_ 0 );
     #endif
  #ifdef __KERNEL__
    }
  #endif
    return addr;
 #else /* ifndef _LCD_MINIMAL */
-   return lcdSetChar( c );
+   return lcdSetChar( LCD_OBJ_ c );
 #endif
 }
 
 #ifndef __KERNEL__
 /*--------------------------------- lcdPuts -----------------------------------
 */
-LCD_CHAR_SIZE_T lcdPuts( const char* str )
+LCD_CHAR_SIZE_T lcdPuts( LCD_OBJ_DECL_ const char* str )
 {
    LCD_ADDR_T addr = 0;
    LCD_CHAR_SIZE_T n = 0;
@@ -1237,7 +2055,7 @@ LCD_CHAR_SIZE_T lcdPuts( const char* str )
 
    while( *str != '\0' && addr >= 0 )
    {
-      addr = lcdPutch( *str++ );
+      addr = lcdPutch( LCD_OBJ_ *str++ );
       n++;
    }
    return n;
@@ -1246,7 +2064,7 @@ LCD_CHAR_SIZE_T lcdPuts( const char* str )
 #if defined( __HARVARD_ARCH__ ) && !defined( _LCD_NO_FLASH_READING )
 /*--------------------------------- lcdPuts -----------------------------------
 */
-LCD_CHAR_SIZE_T _lcdPutsP( PGM_P strP )
+LCD_CHAR_SIZE_T _lcdPutsP( LCD_OBJ_DECL_ PGM_P strP )
 {
    LCD_ADDR_T addr = 0;
    char c;
@@ -1259,7 +2077,7 @@ LCD_CHAR_SIZE_T _lcdPutsP( PGM_P strP )
       c = LCD_PGM_READ_BYTE( strP++ );
       if( c == '\0' )
          break;
-      addr = lcdPutch( c );
+      addr = lcdPutch( LCD_OBJ_ c );
       n++;
    }
    return n;
@@ -1271,7 +2089,7 @@ LCD_CHAR_SIZE_T _lcdPutsP( PGM_P strP )
 #if defined( CONFIG_ST7066U ) && !defined( CONFIG_LCD_NO_UMLAUT )
 /*-----------------------------------------------------------------------------
 */
-LCD_ADDR_T lcdLoadUmlaut( void )
+LCD_ADDR_T lcdLoadUmlaut( LCD_OBJ_DECL )
 {
    LCD_INDEX_T i;
    LCD_ADDR_T addr;
@@ -1290,7 +2108,7 @@ LCD_ADDR_T lcdLoadUmlaut( void )
 
    for( i = 0; i < ARRAY_SIZE( map ); i++ )
    {
-      addr = lcdLoadExtraCharP( *map[i].pData, map[i].position );
+      addr = lcdLoadExtraCharP( LCD_OBJ_ *map[i].pData, map[i].position );
       if( addr < 0 )
          return addr;
    }
@@ -1301,70 +2119,92 @@ LCD_ADDR_T lcdLoadUmlaut( void )
 
 /*-----------------------------------------------------------------------------
 */
-void lcdLoadPredefinedExtraCharacters( void )
+void lcdLoadPredefinedExtraCharacters( LCD_OBJ_DECL )
 {
  #if defined( CONFIG_ST7066U ) && !defined( CONFIG_LCD_NO_UMLAUT )
-   lcdLoadUmlaut();
+   lcdLoadUmlaut( LCD_OBJ );
  #endif
  #ifdef CONFIG_LCD_USE_BACKSLASH
-   lcdLoadExtraCharP( mg_char_backslash, LCD_BACKSLASH_POSITION );
+   lcdLoadExtraCharP( LCD_OBJ_ mg_char_backslash, LCD_BACKSLASH_POSITION );
  #endif
  #ifdef CONFIG_LCD_USE_PARAGRAPH
-   lcdLoadExtraCharP( mg_char_paragraph, LCD_PARAGRAPH_POSITION );
+   lcdLoadExtraCharP( LCD_OBJ_ mg_char_paragraph, LCD_PARAGRAPH_POSITION );
  #endif
 }
 #else
-  #define lcdLoadPredefinedExtraCharacters()
+  #define lcdLoadPredefinedExtraCharacters( o )
 #endif /* else ifndef _LCD_MINIMAL */ 
 /*--------------------------------- lcdInit -----------------------------------
 */
-LCD_ADDR_T lcdInit( void )
+LCD_ADDR_T lcdInit( LCD_OBJ_DECL )
 {
    LCD_ADDR_T addr;
    LCD_POLL_T poll;
 
 #ifndef __KERNEL__
    LCD_DATA_PORT    &= ~LCD_DATA_MASK;
+  #ifdef _LCD_WRITE_ONLY
+   LCD_CONTROL_PORT &= ~(LCD_RS_MASK | LCD_EN_MASK);
+  #else
    LCD_CONTROL_PORT &= ~(LCD_RS_MASK | LCD_RW_MASK | LCD_EN_MASK);
+  #endif
 #endif /* ifndef __KERNEL__ */
 
-   LCD_SET_HIGH_IMPEDANCE();
-   LCD_SELECT_DATA();
-   LCD_MODE_READ();
-   LCD_SET_EN_HIGH();
+   LCD_BUS_IDLE();
 
-#ifndef _LCD_MINIMAL
- #if !(defined( CONFIG_LCD_NO_UMLAUT ) && defined( CONFIG_LCD_NO_TERMINAL ))
+#ifndef _LCD_SCREEN_MODEL
+ #ifndef _LCD_MINIMAL
+  #if !(defined( CONFIG_LCD_NO_UMLAUT ) && defined( CONFIG_LCD_NO_TERMINAL ))
    TRANSITION( LCD_NORMAL );
- #endif
+  #endif
    mg_lcdAutoScroll = TRUE;
-#endif /* ifndef _LCD_MINIMAL */
+ #endif /* ifndef _LCD_MINIMAL */
    mg_lastChar = FALSE;
    mg_displayState = 0;
+#endif /* ifndef _LCD_SCREEN_MODEL */
+#ifdef _LCD_SHADOW_RAM
+   memset( mg_shadow.cgRam, 0, sizeof( mg_shadow.cgRam ) );
+   lcdShadowClear( LCD_OBJ );
+#endif
+   lcdAcSetAddress( LCD_OBJ_ 0, FALSE );
    LCD_INIT_WAIT();
-#ifndef _LCD_DATAPORT_PINS_8
-   LCD_SELECT_INSTRUCTION();
-   _lcdSetData( 0x03 ); // Display = 8 Bit
-   LCD_INIT_WAIT();
-   lcdSetAddress( 0 );
-   _lcdSetData( 0x02 );  // Display = 4 Bit
-   _lcdSetData( 0x02 );  // Display = 4 Bit
-                          // 2 lines  1 lines
-   _lcdSetData( (MAX_Y() > 1)? 0x08 : 0x00 );
- 
-#else /* ifndef _LCD_DATAPORT_PINS_8 */
-   LCD_SELECT_INSTRUCTION();
-                           // 2 lines 1 liune
-   _lcdSetData( (MAX_Y() > 1)? 0x38 : 0x30 );
-#endif /* else of ifndef _LCD_DATAPORT_PINS_8 */
+   if( !LCD_IS_DATAPORT_8() )
+   {
+      LCD_SELECT_INSTRUCTION();
+      LCD_WRITE_NIBBLE( 0x03 ); // Display = 8 Bit
+      LCD_INIT_WAIT();
+      _lcdSetAddress( LCD_OBJ_ 0 );
+      LCD_WRITE_NIBBLE( 0x02 );  // Display = 4 Bit
+      LCD_WRITE_NIBBLE( 0x02 );  // Display = 4 Bit
+                             // 2 lines  1 lines
+      LCD_WRITE_NIBBLE( (MAX_Y() > 1)? 0x08 : 0x00 );
+   }
+   else
+   { /*
+      * Initialization by instruction of the datasheet: The function-set
+      * for 8-bit becomes repeated, so the controller becomes synchronized
+      * independent of its previous mode.
+      */
+      LCD_SELECT_INSTRUCTION();
+      LCD_WRITE_NIBBLE( 0x30 ); // Display = 8 Bit
+      LCD_INIT_WAIT();
+      LCD_WRITE_NIBBLE( 0x30 ); // Display = 8 Bit
+      LCD_INIT_WAIT();
+                              // 2 lines 1 line
+      LCD_WRITE_NIBBLE( (MAX_Y() > 1)? 0x38 : 0x30 );
+   }
+   if( LCD_IS_WRITE_ONLY() )
+      LCD_EXEC_WAIT();
    poll = CONFIG_TLCD_MAX_POLL;
-   while( lcdIsBusy( &addr ) )
+   while( lcdIsBusy( LCD_OBJ_ &addr ) )
    {
       //DEBUG_MESSAGE( "%d\n", poll );
+      LCD_STATISTIC_INC( polls );
       poll--;
       if( poll == 0 )
       {
          ERROR_MESSAGE( ": Unable to initialize LCD\n" );
+         LCD_STATISTIC_INC( pollTimeouts );
          return -1;
       }
       LCD_POLL_FUNCTION();
@@ -1372,12 +2212,40 @@ LCD_ADDR_T lcdInit( void )
    if( addr < 0 )
       return addr;
 
-   lcdOff();  // Display = off
-   lcdSetData( 0x06 );
-   lcdLoadPredefinedExtraCharacters();
-   lcdClrscr();
-   addr = lcdOn();  // Display = on
+   _lcdSetDisplayState( LCD_OBJ_ 0 ); // Display = off
+   lcdSetData( LCD_OBJ_ 0x06 );
+   lcdLoadPredefinedExtraCharacters( LCD_OBJ );
+   addr = _lcdClrscr( LCD_OBJ );
+#ifdef _LCD_SCREEN_MODEL
+   /*
+    * The display becomes switched on and gets its content by the
+    * following lcdFlush().
+    */
+#else
+   mg_displayState = LCD_FLAG_DISPLAY_ON;
+   addr = _lcdSetDisplayState( LCD_OBJ_ mg_displayState );  // Display = on
+#endif
    return addr;
 }
 
+#ifdef _LCD_SCREEN_MODEL
+/*------------------------------ lcdResetScreen -------------------------------
+ * Resets the screen-model and the escape-parser like a power-on without any
+ * bus-access, so the driver can do it under the lock of the screen-model
+ * and lcdInit() under the lock of the bus only.
+ */
+void lcdResetScreen( LCD_OBJ_DECL )
+{
+#ifndef _LCD_MINIMAL
+ #if !(defined( CONFIG_LCD_NO_UMLAUT ) && defined( CONFIG_LCD_NO_TERMINAL ))
+   TRANSITION( LCD_NORMAL );
+ #endif
+   mg_lcdAutoScroll = TRUE;
+#endif /* ifndef _LCD_MINIMAL */
+   mg_lastChar = FALSE;
+   lcdScreenClear( LCD_OBJ );
+   mg_displayState = LCD_FLAG_DISPLAY_ON;
+}
+#endif /* ifdef _LCD_SCREEN_MODEL */
+
 /*================================== EOF ====================================*/
@@ -41,6 +41,19 @@
  #endif
 #endif
 
+#if defined( __KERNEL__ ) && !defined( _LCD_SHADOW_RAM )
+ #define _LCD_SHADOW_RAM
+#endif
+#if defined( __KERNEL__ ) && !defined( _LCD_SCREEN_MODEL )
+ #define _LCD_SCREEN_MODEL
+#endif
+#if defined( _LCD_SCREEN_MODEL ) && !defined( _LCD_SHADOW_RAM )
+ #error Macro _LCD_SCREEN_MODEL requires _LCD_SHADOW_RAM!
+#endif
+#if defined( _LCD_WRITE_ONLY ) && !defined( _LCD_SHADOW_RAM )
+ #error Macro _LCD_WRITE_ONLY requires _LCD_SHADOW_RAM!
+#endif
+
 #ifdef __KERNEL__
    typedef int          LCD_ADDR_T;
    typedef size_t       LCD_CHAR_SIZE_T;
@@ -72,6 +85,27 @@
  #ifndef SET_PATTERN
     #define SET_PATTERN( p ) BIN2BYTE( 000##p )
  #endif
+
+ #define LCD_DDRAM_SIZE  0x80
+ #define LCD_CGRAM_CHARS 8
+
+ #ifdef _LCD_SHADOW_RAM
+   typedef struct
+   {
+      BYTE             ddRam[LCD_DDRAM_SIZE];
+      LCD_CGRAM_CHAR_T cgRam[LCD_CGRAM_CHARS];
+      LCD_ADDR_T       addr;
+      BOOL             isCgRam;
+      BYTE             displayState;
+   } LCD_SHADOW_T;
+ #endif
+ #ifdef _LCD_SCREEN_MODEL
+   typedef struct
+   {
+      BYTE             ddRam[LCD_DDRAM_SIZE];
+      LCD_ADDR_T       addr;
+   } LCD_SCREEN_T;
+ #endif
 #endif
 
 #ifndef CONFIG_LCD_MINIMAL
@@ -127,15 +161,48 @@ extern BYTE mg_displayState;
  #define LCD_MAX_Y   2
 #endif
 
+/*!
+ * @brief Passing of the display-object.
+ *
+ * In the Linux-kernel each display has its own object LCD_OBJ_T which
+ * becomes passed as first argument to each function of this module.
+ * On AVR there is only one display, therefore these macros are empty.
+ */
 #ifdef __KERNEL__
-   #define MAX_X() global.oLcd.maxX
-   #define MAX_Y() global.oLcd.maxY
+   #define LCD_OBJ_DECL  LCD_OBJ_T* pLcd
+   #define LCD_OBJ_DECL_ LCD_OBJ_T* pLcd,
+   #define LCD_OBJ       pLcd
+   #define LCD_OBJ_      pLcd,
+#else
+   #define LCD_OBJ_DECL  void
+   #define LCD_OBJ_DECL_
+   #define LCD_OBJ
+   #define LCD_OBJ_
+#endif
+
+#ifdef __KERNEL__
+   #define MAX_X() pLcd->maxX
+   #define MAX_Y() pLcd->maxY
 #else
    #define MAX_X() LCD_MAX_X
    #define MAX_Y() LCD_MAX_Y
 #endif
 
 
+/*!
+ * @brief States of the escape- and UTF-8-parser of lcdPutch(), the
+ *        tracepoint anLcd_putch_state shows their names.
+ */
+typedef enum
+{
+   LCD_NORMAL,
+   LCD_UMLAUT,
+   LCD_SPECIAL_CHAR,
+   LCD_ESC,
+   LCD_CTRL,
+   LCD_CURSOR
+} LCD_STATUS_T;
+
 #define LCD_FLAG_CMD_ON_OFF_CTRL  0x08
 #define LCD_FLAG_DISPLAY_ON       0x04
 #define LCD_FLAG_CURSOR_ON        0x02
@@ -185,34 +252,57 @@ extern BYTE mg_displayState;
 #ifdef __cplusplus
 extern "C" {
 #endif
-BOOL lcdIsBusy( LCD_ADDR_T* pAddr );
-LCD_ADDR_T lcdInit( void );
-LCD_ADDR_T lcdOn( void );
-LCD_ADDR_T lcdOff( void );
-LCD_ADDR_T lcdCursorOn( void );
-LCD_ADDR_T lcdCursorOff( void );
-LCD_ADDR_T lcdCursorBlink( void );
-LCD_ADDR_T lcdGotoXY( BYTE x, BYTE y );
-LCD_ADDR_T lcdClrscr( void );
-LCD_ADDR_T lcdDelLine( BYTE x );
+BOOL lcdIsBusy( LCD_OBJ_DECL_ LCD_ADDR_T* pAddr );
+LCD_ADDR_T lcdInit( LCD_OBJ_DECL );
+LCD_ADDR_T lcdOn( LCD_OBJ_DECL );
+LCD_ADDR_T lcdOff( LCD_OBJ_DECL );
+LCD_ADDR_T lcdCursorOn( LCD_OBJ_DECL );
+LCD_ADDR_T lcdCursorOff( LCD_OBJ_DECL );
+LCD_ADDR_T lcdCursorBlink( LCD_OBJ_DECL );
+LCD_ADDR_T lcdGotoXY( LCD_OBJ_DECL_ BYTE x, BYTE y );
+LCD_ADDR_T lcdClrscr( LCD_OBJ_DECL );
+LCD_ADDR_T lcdDelLine( LCD_OBJ_DECL_ BYTE x );
 #if LCD_MAX_Y > 1
-LCD_ADDR_T lcdScrollUp( void );
-LCD_ADDR_T lcdScrollDown( void );
-char lcdGetChar( void );
+LCD_ADDR_T lcdScrollUp( LCD_OBJ_DECL );
+LCD_ADDR_T lcdScrollDown( LCD_OBJ_DECL );
+char lcdGetChar( LCD_OBJ_DECL );
+#endif
+#ifdef _LCD_SHADOW_RAM
+char lcdGetShadowChar( LCD_OBJ_DECL_ BYTE x, BYTE y );
+LCD_ADDR_T lcdGetShadowAddress( LCD_OBJ_DECL );
+ #if (LCD_MAX_Y > 1) || defined(__KERNEL__) || defined(_LCD_SCREEN_MODEL)
+char lcdReadChar( LCD_OBJ_DECL_ BYTE x, BYTE y );
+  #ifndef CONFIG_LCD_MINIMAL
+BOOL lcdVerifyBus( LCD_OBJ_DECL );
+  #endif
+ #endif
+#endif
+#ifdef _LCD_SCREEN_MODEL
+char lcdGetScreenChar( LCD_OBJ_DECL_ BYTE x, BYTE y );
+LCD_ADDR_T lcdFlush( LCD_OBJ_DECL );
+void lcdResetScreen( LCD_OBJ_DECL );
+#endif
+LCD_ADDR_T lcdLine2Addr( LCD_OBJ_DECL_ BYTE y );
+LCD_ADDR_T lcdSetAddress( LCD_OBJ_DECL_ LCD_ADDR_T addr );
+LCD_ADDR_T lcdPutch( LCD_OBJ_DECL_ char c );
+LCD_CHAR_SIZE_T lcdPuts( LCD_OBJ_DECL_ const char* str );
+#ifdef __KERNEL__
+void lcdBitBangIdle( LCD_OBJ_T* pLcd );
+void lcdBitBangWriteNibble( LCD_OBJ_T* pLcd, bool isData, u8 data );
+void lcdBitBangWriteByte( LCD_OBJ_T* pLcd, bool isData, u8 data );
+u8 lcdBitBangReadByte( LCD_OBJ_T* pLcd, bool isData );
+static inline BYTE lcdGetDisplayState( LCD_OBJ_DECL ) { return pLcd->displayState; }
+#else
+static inline BYTE lcdGetDisplayState( LCD_OBJ_DECL ) { return mg_displayState; }
 #endif
-LCD_ADDR_T lcdLine2Addr( BYTE y );
-LCD_ADDR_T lcdSetAddress( LCD_ADDR_T addr );
-LCD_ADDR_T lcdPutch( char c );
-LCD_CHAR_SIZE_T lcdPuts( const char* str );
-static inline BYTE lcdGetDisplayState( void ) { return mg_displayState; }
 #if defined( __HARVARD_ARCH__ ) && !defined( CONFIG_LCD_NO_FLASH_READING )
-LCD_CHAR_SIZE_T _lcdPutsP( PGM_P strP );
+LCD_CHAR_SIZE_T _lcdPutsP( LCD_OBJ_DECL_ PGM_P strP );
 #endif
 #ifndef CONFIG_LCD_MINIMAL
-LCD_ADDR_T lcdLoadExtraCharP( const LCD_CGRAM_CHAR_T extraChar, BYTE position );
-static inline void lcdEnableAutoScroll( void )  LCD_ATTR_ALWAYS_INLINE;
-static inline void lcdDisableAutoScroll( void ) LCD_ATTR_ALWAYS_INLINE;
-static inline BOOL lcdIsAutoScroll( void )      LCD_ATTR_ALWAYS_INLINE;
+LCD_ADDR_T lcdLoadExtraCharP( LCD_OBJ_DECL_ const LCD_CGRAM_CHAR_T extraChar, BYTE position );
+static inline void lcdEnableAutoScroll( LCD_OBJ_DECL )  LCD_ATTR_ALWAYS_INLINE;
+static inline void lcdDisableAutoScroll( LCD_OBJ_DECL ) LCD_ATTR_ALWAYS_INLINE;
+static inline BOOL lcdIsAutoScroll( LCD_OBJ_DECL )      LCD_ATTR_ALWAYS_INLINE;
 #endif
 #ifdef LCD_POLL_FUNCTION
 void LCD_POLL_FUNCTION ( void );
@@ -231,19 +321,19 @@ void LCD_BELL_FUNCTION ( void );
  #define _lcdPutsP( str ) lcdPuts( str )
 #endif
 #if LCD_MAX_Y == 1
- #define lcdScrollUp()   lcdDelLine( 1 )
- #define lcdScrollDown() lcdDelLine( 1 )
+ #define lcdScrollUp( o )   lcdDelLine( LCD_OBJ_ 1 )
+ #define lcdScrollDown( o ) lcdDelLine( LCD_OBJ_ 1 )
 #endif
 
 #ifndef CONFIG_LCD_MINIMAL
 #ifdef __KERNEL__
-  void lcdEnableAutoScroll( void )  { global.oLcd.autoScroll = TRUE; }
-  void lcdDisableAutoScroll( void ) { global.oLcd.autoScroll = FALSE; }
-  BOOL lcdIsAutoScroll( void )      { return global.oLcd.autoScroll; }
+  void lcdEnableAutoScroll( LCD_OBJ_DECL )  { pLcd->autoScroll = TRUE; }
+  void lcdDisableAutoScroll( LCD_OBJ_DECL ) { pLcd->autoScroll = FALSE; }
+  BOOL lcdIsAutoScroll( LCD_OBJ_DECL )      { return pLcd->autoScroll; }
 #else
-  void lcdEnableAutoScroll( void )  { mg_lcdAutoScroll = TRUE; }
-  void lcdDisableAutoScroll( void ) { mg_lcdAutoScroll = FALSE; }
-  BOOL lcdIsAutoScroll( void )      { return mg_lcdAutoScroll; }
+  void lcdEnableAutoScroll( LCD_OBJ_DECL )  { mg_lcdAutoScroll = TRUE; }
+  void lcdDisableAutoScroll( LCD_OBJ_DECL ) { mg_lcdAutoScroll = FALSE; }
+  BOOL lcdIsAutoScroll( LCD_OBJ_DECL )      { return mg_lcdAutoScroll; }
 #endif
 #ifdef CONFIG_LCD_UNICODE
  #define LCD_UMLAUT_INTRUDUCHER       0xC3
@@ -261,6 +351,6 @@ void LCD_BELL_FUNCTION ( void );
 #if defined( CONFIG_AN_LCD_READBACK ) && defined( _CONVERT_CHAR8 )
  BOOL lcdConvertBackChar8( char* pChar );
 #endif
- void lcdLoadPredefinedExtraCharacters( void );
+ void lcdLoadPredefinedExtraCharacters( LCD_OBJ_DECL );
 #endif /* ifndef _HD44780DISPLAY_H */
 /*================================== EOF ====================================*/